@@ -0,0 +1,71 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+#include "memory.h"
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+//Longest straight-line run decoded into a single block
+constexpr int MAX_BLOCK_OPS = 32;
+constexpr int MAX_OP_LENGTH = 3;
+//Direct-mapped table of recently entered blocks, checked before the hash map
+constexpr int RECENT_BLOCKS = 1024;
+
+typedef struct DecodedOp{
+    Regval16 pc;
+    uint8_t length;
+    Regval8 bytes[MAX_OP_LENGTH];   //opcode followed by its operands
+}DecodedOp;
+
+/**
+ * @brief Cache of pre-decoded straight-line runs of code, keyed on ROM bank and
+ * address. Blocks end at the first instruction that can change control flow, so
+ * consecutive instructions are served without touching the bus. Blocks decoded
+ * from WRAM or HRAM mark the pages they cover, and are all dropped as soon as
+ * one of those pages is written.
+ */
+class BlockCache{
+    private:
+        Bus& bus;
+        Memory<SYS_PERM> mem;
+        std::unordered_map<uint32_t, std::vector<DecodedOp>> blocks;
+        std::vector<uint32_t> ramBlocks;
+        struct RecentBlock{
+            uint32_t key;
+            const std::vector<DecodedOp>* ops;
+        };
+        std::array<RecentBlock, RECENT_BLOCKS> recent;
+        const DecodedOp* curr;
+        const DecodedOp* currEnd;
+        int currBank;
+
+        static const std::array<uint8_t, 256> opLengths;
+        static const std::array<bool, 256> blockEnds;
+        static std::array<uint8_t, 256> buildOpLengths();
+        static std::array<bool, 256> buildBlockEnds();
+        static bool inRegion(Regval16 addr, Regval16& regionEnd);
+        int bankOf(Regval16 addr);
+        std::vector<DecodedOp> decode(Regval16 addr, Regval16 regionEnd);
+        void flushRam();
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param bus bus state of the machine whose code gets cached
+         */
+        BlockCache(Bus& bus);
+        /**
+         * @brief Gives the decoded instruction at an address, decoding the block
+         * starting there if it isn't cached yet.
+         *
+         * @param addr address of the instruction, normally the program counter
+         *
+         * @return decoded instruction, or nullptr if code at this address can't be cached
+         */
+        const DecodedOp* fetch(Regval16 addr);
+        /**
+         * @brief Drops every cached block, e.g. after loading another game.
+         */
+        void flush();
+};
+#endif
@@ -0,0 +1,129 @@
+#ifndef CART_RAM_H
+#define CART_RAM_H
+#include "gb_types.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//Granularity of write tracking, one entry of the Bus page tables
+constexpr size_t CART_RAM_PAGE_SIZE = 256;
+
+/**
+ * @brief Cartridge RAM, either plain memory or a shared mapping of the save file.
+ * A save file can hold MBC state in a trailer after the RAM, which is mapped along
+ * with it.
+ * A mapped file is written by every store to it, so the saves survive the process
+ * being killed. A background thread pushes the pages written since the last
+ * handOff() out to disk, so they also survive the machine going down.
+ *
+ * Only the pages that have been written to are flushed. The Bus maps a page for
+ * writing only once it has been marked dirty, so the first store to a clean page
+ * takes the slow path and is seen here.
+ */
+class CartRam{
+    private:
+        Regval8* bytes;
+        size_t size;
+        size_t trailerSize;
+        size_t savedTrailerSize;
+        //set when the file is mapped, holds the RAM otherwise
+        void* mapping;
+        std::vector<Regval8> buffer;
+#ifdef _WIN32
+        void* file;
+#endif
+        //Pages written since the last hand-off, only touched by the emulation thread
+        std::vector<bool> dirty;
+        bool anyDirty;
+        //Pages handed to the flush thread, guarded by lock
+        std::mutex lock;
+        std::condition_variable wake;
+        std::vector<bool> pending;
+        bool anyPending;
+        bool stopping;
+        std::thread flusher;
+
+        void flushLoop();
+        void flushPages(const std::vector<bool>& pages);
+    public:
+        /**
+         * @brief Constructor for RAM that isn't backed by a file.
+         *
+         * @param size size in bytes
+         */
+        CartRam(size_t size);
+        /**
+         * @brief Constructor for RAM backed by a save file. The file is created, or
+         * padded out with zeros, if it is smaller than the RAM and trailer. Anything
+         * past the end of those is left alone. If the file can't be mapped the RAM is
+         * plain memory, and isMapped() tells so.
+         *
+         * @param size size in bytes
+         *
+         * @param filename path of the .sav file
+         *
+         * @param trailerSize bytes of MBC state kept after the RAM
+         */
+        CartRam(size_t size, const std::string& filename, size_t trailerSize = 0);
+        ~CartRam();
+        CartRam(const CartRam&) = delete;
+        CartRam& operator=(const CartRam&) = delete;
+        Regval8* data();
+        Regval8& operator[](size_t offset);
+        size_t getSize() const;
+        bool empty() const;
+        /**
+         * @brief Tells whether the RAM is a mapping of its save file.
+         *
+         * @return true if mapped, false for plain memory
+         */
+        bool isMapped() const;
+        /**
+         * @brief Gives the trailer of a mapped save file, which is flushed along
+         * with the RAM once marked dirty at offset getSize().
+         *
+         * @return first byte of the trailer, or nullptr if there's none mapped
+         */
+        Regval8* getTrailer();
+        /**
+         * @brief Gives how much of the trailer the save file held before it was
+         * mapped, which is less than asked for if it was written in an older format
+         * or didn't exist.
+         *
+         * @return size in bytes
+         */
+        size_t getSavedTrailerSize() const;
+        /**
+         * @brief Tells whether stores to a page may skip markDirty(). That's always
+         * the case unless the RAM is mapped.
+         *
+         * @param offset any offset within the page
+         *
+         * @return true if the page can be mapped for writing
+         */
+        bool isWritable(size_t offset) const;
+        /**
+         * @brief Records a store to the RAM.
+         *
+         * @param offset offset of the byte written
+         *
+         * @return true if the page was clean, and so needs mapping for writing
+         */
+        bool markDirty(size_t offset);
+        /**
+         * @brief Hands the dirty pages to the flush thread and marks them clean.
+         * Never waits on the flush thread, if it is busy taking the last batch the
+         * pages are kept for the next call.
+         *
+         * @return true if pages were handed off, and so need unmapping for writing
+         */
+        bool handOff();
+        /**
+         * @brief Writes every change to the save file out to disk before returning.
+         */
+        void sync();
+};
+#endif
@@ -1,16 +1,43 @@
 #include "memory.h"
+#include "interrupts.h"
 
 class Counters{
     private:
-        Memory mem;
+        Memory<COUNTER_PERM> mem;
         Register divReg;
         Register timaReg;
         Register tmaReg; 
         Register tacReg;
-        Register intFlagReg;
+        Interrupts interrupts;
         int divCycleCount;
         int timaCycleCount;
+        //decoded from TAC whenever it is written
+        int intervalLen;
+        bool timerEnabled;
+
+        int getIntervalLen();
+        void updateTimerControl();
     public:
-        Counters();
+        Counters(Bus& bus);
         void emulateCycle();
+        /**
+            @brief Advances DIV and TIMA by several cycles at once. Equivalent to
+            calling emulateCycle() n times, as long as TAC and TMA don't change.
+
+            @param n number of cycles to advance
+        */
+        void emulateCycles(int n);
+        /**
+            @brief Gives the number of cycles before DIV is next incremented.
+
+            @return cycles until the increment
+        */
+        int cyclesUntilDivInc();
+        /**
+            @brief Gives the number of cycles before TIMA next overflows and requests
+            a timer interrupt, assuming TIMA, TMA and TAC are left alone.
+
+            @return cycles until the overflow, or NO_EVENT if the timer can't overflow
+        */
+        int cyclesUntilTimaOverflow();
 };
\ No newline at end of file
@@ -17,6 +17,7 @@ constexpr uint8_t ZERO_FLAG = 0b10000000;
 constexpr uint8_t SUBTRACT_FLAG = 0b01000000;
 constexpr uint8_t HALF_CARRY_FLAG = 0b00100000;
 constexpr uint8_t CARRY_FLAG = 0b00010000;
+constexpr uint8_t ALL_FLAGS = ZERO_FLAG | SUBTRACT_FLAG | HALF_CARRY_FLAG | CARRY_FLAG;
 
 //Condition enum
 typedef enum Condition{
@@ -37,10 +38,22 @@ typedef enum BitIndex{
     BIT_SEVEN = 0x80
 }BitIndex;
 
-typedef enum Operation{
-    ADD,
-    SUB,
-}Operation;
+//ALU operations whose flags can be worked out after the fact
+typedef enum FlagOp{
+    FLAGS_ADD,      //8-bit a + b + carry
+    FLAGS_SUB,      //8-bit a - b - carry
+    FLAGS_ADD_16    //16-bit a + b, H and C out of bits 11 and 15
+}FlagOp;
+
+//Operands of the last ALU operation, for the flags it still owes F
+typedef struct LazyFlags{
+    FlagOp op;
+    Regval8 mask;       //flags not yet written to F, 0 if F is up to date
+    Regval16 a;
+    Regval16 b;
+    Regval8 carry;
+    Regval8 result;
+}LazyFlags;
 
 
 typedef enum RegIndex_8{
@@ -52,16 +65,21 @@ typedef enum RegIndex_16{
 }RegIndex_16;
 
 class CPU{
+    //compiled code works on the registers directly
+    friend class Jit;
     private:
         Regval8 regs_8[8];
         Regval16 regs_16[4];
-        Memory mem;
-
-        bool fullCarry(Regval8 val1, Regval8 val2, Operation op, bool withCarry);
-        bool halfCarry(Regval8 prev, Regval8 curr, Operation op, bool withCarry);
+        Memory<CPU_PERM> mem;
+        LazyFlags lazy;
+
+        void deferFlags(FlagOp op, Regval16 a, Regval16 b, Regval8 carry, Regval8 result, Regval8 mask);
+        void setFlags(Regval8 mask, Regval8 flags);
+        Regval8 computeFlags();
+        void resolveFlags();
+        bool getFlag(Regval8 flag);
         Regval16 getRegPair(RegIndex_8 msr, RegIndex_8 lsr);
         void setRegPair(RegIndex_8 msr, RegIndex_8 lsr, Regval16 val);
-        void addRegRegCarry(RegIndex_8 reg1, RegIndex_8 reg2);
         void pushPC();
         void pushPCInc();
         void popPC();
@@ -71,9 +89,9 @@ class CPU{
         /**
             @brief Constructor
 
-            @param mem reference to memory handler
+            @param bus bus state of the owning machine
         */
-        CPU();
+        CPU(Bus& bus);
         /**
             @brief  Adds a GP register's value to reg A.
 
@@ -170,14 +188,14 @@ class CPU{
 
             @param reg Register to compare.
 
-            @return Flag register state.
+            @return Result of the subtraction.
         */
        Regval8 compareReg(RegIndex_8 reg);
         /**
             @brief Subtracts the contents of the address in HL from reg A 
             (without modifying it) and sets flags accordingly.
 
-            @return Flag register state
+            @return Result of the subtraction.
         */
        Regval8 compareIndirect();
         /**
@@ -185,7 +203,7 @@ class CPU{
 
             @param imm Immediate to compare.
 
-            @return Flag register state
+            @return Result of the subtraction.
         */
        Regval8 compareImm(Regval8 imm);
         /**
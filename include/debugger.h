@@ -8,7 +8,6 @@ class Debugger{
     private:
         std::vector<Regval16> breakPts;
         Gameboy& gb;
-        Signal signal;
 
     public:
         Debugger(Gameboy& rgb);
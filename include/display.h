@@ -0,0 +1,49 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+#include "SDL2/SDL.h"
+#include "lcd.h"
+#include "triple_buffer.h"
+#include "frame_sink.h"
+
+constexpr int WIN_DIMENSION_SCALE_FACTOR = 2;
+
+/**
+ * @brief Frame sink showing frames in an SDL window. Submitted frames are only
+ * published through a triple buffer, uploading and presenting happen on whichever
+ * thread calls present(), so a slow driver or a vsync wait holds up that thread
+ * rather than the one emulating.
+ *
+ * SDL wants a window driven from the thread that made it, so a Display is to be made,
+ * presented, and have its events pumped all on one thread.
+ */
+class Display : public FrameSink{
+    private:
+        TripleBuffer<FrameBuffer> frames;
+        SDL_Window* window;
+        SDL_Renderer* renderer;
+        SDL_Texture* frameTexture;
+    public:
+        /**
+         * @brief Constructor, opens the window. SDL video has to be initialized.
+         */
+        Display();
+        ~Display();
+        Display(const Display&) = delete;
+        Display& operator=(const Display&) = delete;
+        FrameBuffer& nextFrame() override;
+        void submitFrame() override;
+        /**
+         * @brief Uploads and presents the latest frame, if one was published since
+         * the last call. Presenting waits for vsync.
+         *
+         * @return true if a frame was presented, false if there was none new
+         */
+        bool present();
+        /**
+         * @brief Gives the refresh rate of the display the window is on.
+         *
+         * @return refresh rate in Hz, or 0 if the display doesn't report one
+         */
+        int getRefreshRate();
+};
+#endif
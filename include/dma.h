@@ -11,14 +11,38 @@ typedef enum DmaState{
 
 class DMA{
     private:
-        Memory mem;
+        Memory<DMA_PERM> mem;
         Register dmaReg;
         Regval8 regVal;
         DmaState state;
         int cyclesLeft;
+        //set by writes to the DMA register, picked up on the next cycle
+        bool requested;
+        Regval8 requestedSrc;
+
+        void request(Regval8 byte);
     
     public:
-        DMA();
+        DMA(Bus& bus);
         void emulateCycle();
+        /**
+            @brief Checks whether a transfer is requested or in progress.
+
+            @return true if the DMA has work to do on upcoming cycles
+        */
+        bool isActive();
+        /**
+            @brief Runs the DMA for several cycles at once. Equivalent to calling
+            emulateCycle() n times.
+
+            @param n number of cycles to run
+        */
+        void emulateCycles(int n);
+        /**
+            @brief Gives the number of cycles before the DMA next starts or finishes a transfer.
+
+            @return cycles until the next event, or NO_EVENT if idle
+        */
+        int cyclesUntilEvent();
 };
 #endif
\ No newline at end of file
@@ -36,7 +36,7 @@ class Fetcher{
         std::vector<GbPixel> spriteFifo;
         std::vector<GbPixel> spriteBuffer;
 
-        Memory mem;
+        Memory<PPU_PERM> mem;
 
         Register lcdcReg;
         Register lyReg;
@@ -69,7 +69,7 @@ class Fetcher{
         void clearSpriteFifo();
 
     public:
-        Fetcher();
+        Fetcher(Bus& bus);
         bool emulateFetchCycle();
         Regval8 getBgFifoSize();
         Regval8 getSpriteFifoSize();
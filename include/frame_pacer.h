@@ -0,0 +1,86 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+#include <chrono>
+#include <cstdint>
+
+//Bounds of the stretch before a deadline that is spun through rather than slept
+constexpr std::chrono::microseconds MIN_SPIN_WINDOW(50);
+constexpr std::chrono::microseconds MAX_SPIN_WINDOW(4000);
+constexpr std::chrono::microseconds INITIAL_SPIN_WINDOW(1000);
+//The spin window shrinks by a step on every sleep it covers and grows by n - 1 steps
+//on every one it doesn't, so it settles where about one sleep in n oversleeps it
+constexpr std::chrono::microseconds SPIN_WINDOW_STEP(10);
+constexpr int LATE_WAKE_RATIO = 20;
+
+typedef struct PacerStats{
+    uint64_t numFrames;   //frames paced since the last reset
+    double meanFrameMs;   //mean time between frames
+    double jitterMs;      //standard deviation of the time between frames
+    double maxLateMs;     //latest a frame was released past its deadline
+    double spinWindowMs;  //current spin window
+}PacerStats;
+
+/**
+ * @brief Paces frames to a fixed rate without burning a core. Deadlines are absolute,
+ * so timing errors don't add up over frames. Each wait sleeps until shortly before
+ * the deadline and spins only for the rest. The spin window tracks a high percentile
+ * of how late the OS wakes the thread, so it's small on a quiet host and grows on a
+ * busy one without chasing every one-off preemption.
+ *
+ * Falling behind by more than a frame drops the missed deadlines rather than
+ * running frames back to back to catch up.
+ */
+class FramePacer{
+    private:
+        std::chrono::steady_clock::duration period;
+        std::chrono::steady_clock::time_point deadline;
+        std::chrono::steady_clock::time_point lastFrame;
+        std::chrono::steady_clock::duration spinWindow;
+        uint64_t numFrames;
+        //frames that kept to the schedule, and so are counted in the frame times
+        uint64_t numTimed;
+        double frameSumMs;
+        double frameSumSqMs;
+        double maxLateMs;
+
+        void sleepUntil(std::chrono::steady_clock::time_point time);
+        void adaptSpinWindow(std::chrono::steady_clock::duration oversleep);
+        //tells whether a frame released now keeps to the schedule rather than resyncing it
+        bool onSchedule(std::chrono::steady_clock::time_point now);
+        void release(std::chrono::steady_clock::time_point now);
+    public:
+        /**
+         * @brief Constructor.
+         *
+         * @param rate frames per second
+         */
+        FramePacer(double rate);
+        /**
+         * @brief Changes the frame rate, starting a new schedule.
+         *
+         * @param rate frames per second
+         */
+        void setRate(double rate);
+        /**
+         * @brief Blocks until the deadline of the next frame.
+         */
+        void wait();
+        /**
+         * @brief Releases the next frame only if its deadline has passed, never blocking.
+         * For callers that run flat out and want to act at the paced rate.
+         *
+         * @return true if the frame was released
+         */
+        bool poll();
+        /**
+         * @brief Forgets the schedule and stats, the next wait() starts a new one.
+         */
+        void reset();
+        /**
+         * @brief Gives timing figures of the frames paced since the last reset.
+         *
+         * @return pacing stats
+         */
+        PacerStats getStats();
+};
+#endif
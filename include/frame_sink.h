@@ -0,0 +1,72 @@
+#ifndef FRAME_SINK_H
+#define FRAME_SINK_H
+#include "lcd.h"
+#include <memory>
+
+/**
+ * @brief Where a PPU's finished frames go. The PPU draws straight into the buffer
+ * nextFrame() gives and calls submitFrame() once it's whole. Both are called on the
+ * emulation thread and must not block.
+ */
+class FrameSink{
+    public:
+        virtual ~FrameSink() = default;
+        /**
+         * @brief Gives the buffer the next frame is to be drawn into. Stays the same
+         * until submitFrame() is called.
+         *
+         * @return frame buffer to draw into
+         */
+        virtual FrameBuffer& nextFrame() = 0;
+        /**
+         * @brief Takes the frame drawn into the buffer from nextFrame().
+         */
+        virtual void submitFrame() = 0;
+        /**
+         * @brief Tells whether frames are looked at all. The PPU doesn't draw for a
+         * sink that doesn't.
+         *
+         * @return false if frames are thrown away
+         */
+        virtual bool showsFrames();
+};
+
+/**
+ * @brief Sink that throws every frame away, so nothing gets drawn.
+ */
+class NullFrameSink : public FrameSink{
+    private:
+        std::unique_ptr<FrameBuffer> buffer;
+    public:
+        NullFrameSink();
+        FrameBuffer& nextFrame() override;
+        void submitFrame() override;
+        bool showsFrames() override;
+};
+
+/**
+ * @brief Sink that keeps the last frame in memory, for looking at without a display.
+ */
+class MemoryFrameSink : public FrameSink{
+    private:
+        std::unique_ptr<FrameBuffer> drawing;
+        std::unique_ptr<FrameBuffer> last;
+        int numFrames;
+    public:
+        MemoryFrameSink();
+        FrameBuffer& nextFrame() override;
+        void submitFrame() override;
+        /**
+         * @brief Gives the last frame submitted, blank until there is one.
+         *
+         * @return last frame
+         */
+        const FrameBuffer& getLastFrame();
+        /**
+         * @brief Gives the number of frames submitted so far.
+         *
+         * @return frame count
+         */
+        int getFrameCount();
+};
+#endif
@@ -4,10 +4,43 @@
 #include "cpu.h"
 #include "ppu.h"
 #include "memory.h"
-#include "SDL2/SDL.h"
 #include "dma.h"
 #include "counters.h"
+#include "joypad.h"
+#include "scheduler.h"
+#include "block_cache.h"
+#include "jit.h"
+#include "interrupts.h"
+#include "spsc_queue.h"
+#include <memory>
+#include <chrono>
+#include <array>
 constexpr uint32_t CYCLE_RATE = 4194304; //Hz
+constexpr int CYCLES_PER_M_CYCLE = 4;
+//Longest stretch a HALT or idle loop is skipped over at once, so callers still get control back every frame
+constexpr int MAX_SKIP_CYCLES = CYCLES_PER_LINE * SCAN_HEIGHT;
+//How often RAM written to is handed off to be flushed to the save file
+constexpr uint64_t SRAM_FLUSH_CYCLES = CYCLE_RATE / 4;
+//How often input posted from other threads is picked up
+constexpr uint64_t HOST_INPUT_POLL_CYCLES = CYCLES_PER_LINE;
+//Inputs that can be posted ahead of being picked up
+constexpr size_t HOST_INPUT_QUEUE_SIZE = 64;
+//Most posted inputs waiting on a frame to be shown that are kept for latency stats
+constexpr size_t MAX_UNSHOWN_INPUTS = 256;
+
+//What an idle loop reads, and so which events can end it
+typedef enum PollSource{
+    POLL_PPU = 0x01,            //LY, STAT, IF and CPU access to VRAM/OAM change on PPU mode and line changes
+    POLL_TIMA_OVERFLOW = 0x02,  //IF changes when TIMA overflows
+    POLL_DIV = 0x04,            //DIV changes on its own increments
+    POLL_UNBOUNDED = 0x08,      //changes too often to be worth skipping over
+    POLL_JOYPAD = 0x10          //JOYP and IF change on queued input
+}PollSource;
+
+typedef enum RunMode{
+    CYCLE_STEP,         //CPU and peripherals advance together, one cycle per step
+    INSTRUCTION_STEP    //CPU runs a whole instruction per step, peripherals catch up after
+}RunMode;
 
 typedef enum InstrState{
     FETCH_OP,
@@ -25,16 +58,58 @@ typedef struct GbState{
     Regval16 regs_16[4];
 }GbState;
 
+typedef struct SkipStats{
+    uint64_t haltCycles;        //cycles fast-forwarded while halted
+    uint64_t idleLoopCycles;    //cycles fast-forwarded in idle polling loops
+}SkipStats;
+
+//Joypad state posted from another thread, along with when it was posted
+typedef struct HostInput{
+    Regval8 state;
+    std::chrono::high_resolution_clock::time_point postedAt;
+}HostInput;
+
+typedef struct InputStats{
+    uint64_t numInputs;         //posted inputs that have made it to the screen
+    double meanLatencyMs;       //from being posted to the first frame published after being applied
+    double maxLatencyMs;
+}InputStats;
+
+typedef struct MemoryStats{
+    size_t instanceBytes;       //fixed-size state owned by this instance alone
+    size_t sharedRomBytes;      //ROM image, shared with every instance running the same ROM
+    long romUsers;              //instances sharing the ROM image, this one included
+}MemoryStats;
+
+//Candidate idle loop, as of the start of its latest pass
+typedef struct IdleLoop{
+    Regval16 head;
+    GbState cpuState;
+    bool IME;
+    bool sideEffects;
+    Regval8 polled;
+    uint64_t startCycle;    //peripheral cycle the pass started on
+}IdleLoop;
+
 
 class Gameboy{
     private:
+        std::unique_ptr<Bus> bus;
         CPU cpu;
         PPU ppu;
         DMA dma;
         Counters counters;
+        Joypad joypad;
+        Scheduler scheduler;
+        BlockCache blockCache;
+        const DecodedOp* decodedOp;
+#ifdef USE_JIT
+        Jit jit;
+        bool jitEnabled;
+#endif
         Signal signal;
-        Memory mem;
-        Regval8 joypadBuff;
+        Interrupts interrupts;
+        Memory<SYS_PERM> mem;
         uint8_t opcode;
         uint8_t cb_op;
         InstrState state;
@@ -44,25 +119,122 @@ class Gameboy{
         Regval8 msb;
         Regval8 lsb;
         bool IME;
+        //set by EI, IME only goes up once the instruction after it has been fetched
+        bool imeDelay;
+        //set when HALT doesn't halt, the byte after it is then fetched twice
+        bool haltBug;
+        int numCycles;
+        RunMode runMode;
+        int pendingCycles;
+        uint64_t peripheralCycles;
+        bool rescheduleNeeded;
+        uint64_t totalCycles;
+        uint64_t lastEventCycle;
+        uint64_t nextSramFlush;
+        IdleLoop idleLoop;
+        SkipStats skipStats;
+        SpscQueue<HostInput, HOST_INPUT_QUEUE_SIZE> hostInput;
+        uint64_t nextInputPoll;
+        //posted inputs applied but not shown yet, all applied during frame unshownFrame
+        std::vector<std::chrono::high_resolution_clock::time_point> unshownInputs;
+        int unshownFrame;
+        InputStats inputStats;
+        double latencySumMs;
+        bool recordingInput;
+        std::vector<JoypadEvent> inputLog;
  
         void printDebug(char* s);
-        void limitCycleRate();
         void runFSM();
-        void handleEvent(SDL_Event* event);
         void executeCBOP();
         void printSerial();
-        void clearInterrupt(Regval8 mask);
         void handleInterrupt();
+        void catchUp();
+        void schedulePeripherals();
+        void scheduleIn(EventType type, int cycles);
+        void reschedule(EventType type);
+        void skipHalt();
+        void pollHostInput();
+#ifdef USE_JIT
+        bool runJit();
+#endif
+
+        //Idle loop detection, defined in idle_loop.cpp
+        static const std::array<bool, 256> pollSafeOps;
+        static std::array<bool, 256> buildPollSafeOps();
+        static Regval8 pollSource(Regval16 addr);
+        bool isPollSafe();
+        void trackIdleLoop(Regval16 startPC);
+        void skipIdleLoop(uint64_t passCycles);
+
+        //Opcode dispatch, defined in dispatch.cpp
+        typedef void (Gameboy::*OpHandler)();
+        static const std::array<OpHandler, 256> opTable;
+        static const std::array<OpHandler, 256> cbTable;
+        static std::array<OpHandler, 256> buildOpTable();
+        static std::array<OpHandler, 256> buildCbTable();
+        void fetchImm16();
+        Regval8 fetchByte();
+        void opNop();
+        void opHalt();
+        void opStop();
+        void opDi();
+        void opEi();
+        void opJumpHL();
+        void opInvalid();
+        void opLoadSPImm();
+        void opLoadDirectSP();
+        void opJump();
+        void opJumpRel();
+        void opCall();
+        void opRet();
+        void opReti();
+        void opCB();
+        template<auto op> void opImplied();
+        template<auto op, RegIndex_8 reg> void opReg();
+        template<RegIndex_8 dst, RegIndex_8 src> void opLoadRegReg();
+        template<auto op> void opRotateA();
+        template<RegIndex_8 msr, RegIndex_8 lsr> void opAddHLRegPair();
+        template<auto op> void opIndirect();
+        template<auto op, RegIndex_8 reg> void opIndirectReg();
+        template<auto op> void opImm();
+        template<auto op> void opImmDelayed();
+        template<auto op> void opOffset();
+        template<auto op> void opOffsetDelayed();
+        template<RegIndex_8 reg> void opLoadRegImm();
+        template<RegIndex_8 msr, RegIndex_8 lsr> void opLoadRegPairImm();
+        template<auto op> void opDirect();
+        template<auto op, RegIndex_8 msr, RegIndex_8 lsr> void opStack();
+        template<Condition cond> void opJumpCond();
+        template<Condition cond> void opJumpRelCond();
+        template<Condition cond> void opCallCond();
+        template<Condition cond> void opRetCond();
+        template<Regval8 addr> void opRst();
+        template<auto op, RegIndex_8 reg> void cbRotate();
+        template<auto op, RegIndex_8 reg> void cbShift();
+        template<auto op> void cbIndirect();
+        template<auto op, RegIndex_8 reg, BitIndex index> void cbBit();
+        template<auto op, BitIndex index> void cbBitIndirect();
     public:
+        /**
+            @brief Backs cartridge RAM with a save file, loaded after the game. RAM
+            writes go straight to the file and are flushed to disk in the background
+            within SRAM_FLUSH_CYCLES. If the file can't be mapped it is read into RAM
+            instead, to be written back by saveSram().
+
+            @param filename filename of the .sav file.
+
+            @return false if the file could neither be mapped nor read.
+        */
         bool loadSram(std::string filename);
         void saveSram(std::string filename);
         Gameboy();
         /**
-            @brief Loads the game into program memory.
+            @brief Maps the game into program memory. The file is mapped read-only
+            rather than copied, so it has to stay in place while it is being played.
 
             @param filename filename of the desired game.
 
-            @return total bytes read during loading process.
+            @return size of the ROM in bytes.
         */
         size_t loadGame(std::string filename);
         /**
@@ -71,6 +243,56 @@ class Gameboy{
          * @return current address of program counter
          */
         Regval16 emulateCycle();
+        /**
+         * @brief Emulates one full instruction, then lets the peripherals catch up
+         * on the cycles it took. Only available in INSTRUCTION_STEP mode.
+         * 
+         * @return current address of program counter
+         */
+        Regval16 emulateInstruction();
+        /**
+         * @brief Emulates one cycle or one instruction, depending on the run mode
+         * 
+         * @return current address of program counter
+         */
+        Regval16 step();
+        /**
+         * @brief Switches between cycle and instruction stepping. Safe to call at any
+         * point, the machine is brought to an M-cycle boundary first.
+         * 
+         * @param mode desired run mode
+         */
+        void setRunMode(RunMode mode);
+        RunMode getRunMode();
+        /**
+         * @brief Runs hot stretches of ROM code as compiled x86-64 code instead of
+         * interpreting them. Only takes effect in INSTRUCTION_STEP mode, and only
+         * in builds made with JIT=1.
+         * 
+         * @param enabled true to use compiled code where possible
+         */
+        void setJitEnabled(bool enabled);
+        /**
+         * @brief Gives the number of cycles the CPU has run since power on
+         * 
+         * @return elapsed cycles
+         */
+        uint64_t getCycleCount();
+        /**
+         * @brief Gives how many cycles were fast-forwarded instead of emulated
+         * one by one, in halts and in idle loops polling the peripherals.
+         * 
+         * @return SkipStats struct with the skipped cycle counts
+         */
+        SkipStats getSkipStats();
+        /**
+         * @brief Gives how much memory this instance holds on its own, apart from
+         * the ROM image it shares with other instances of the same game.
+         * Caches that grow with the code run, like decoded blocks, aren't counted.
+         * 
+         * @return MemoryStats struct with the byte counts
+         */
+        MemoryStats getMemoryStats();
         /**
          * @brief Gives current state of emulator
          * 
@@ -82,9 +304,126 @@ class Gameboy{
         */
         void printStatus();
 
+        /**
+         * @brief Changes the buttons held, starting with the next cycle emulated.
+         * 
+         * @param byte joypad state, with the bit of every button held cleared
+         */
         void setJoypad(Regval8 byte);
-        
+        /**
+         * @brief Gives the buttons held, counting changes that are queued but not
+         * yet applied.
+         * 
+         * @return joypad state
+         */
         Regval8 getJoypad();
+        /**
+         * @brief Queues a change of buttons held for an exact cycle, as counted by
+         * getCycleCount(). Changes must be queued in order, one stamped before the
+         * last one queued is moved up to it and recorded as such. Queueing a whole
+         * recording up front replays it the same way as feeding it in live.
+         * 
+         * @param cycle cycle the change happens on
+         * 
+         * @param state joypad state from then on
+         */
+        void queueInput(uint64_t cycle, Regval8 state);
+        /**
+         * @brief Posts a change of buttons held, to be picked up within
+         * HOST_INPUT_POLL_CYCLES. Unlike the other methods this can be called from a
+         * thread other than the one stepping the machine, as long as it's always the
+         * same one.
+         * 
+         * @param state joypad state
+         * 
+         * @return true if posted, false if too many posts are still waiting
+         */
+        bool postInput(Regval8 state);
+        /**
+         * @brief Posts a change of buttons held that happened earlier, such as a host
+         * event that waited in a queue. Latency is counted from when it happened.
+         * 
+         * @param state joypad state
+         * 
+         * @param happenedAt time of the change
+         * 
+         * @return true if posted, false if too many posts are still waiting
+         */
+        bool postInput(Regval8 state, std::chrono::high_resolution_clock::time_point happenedAt);
+        /**
+         * @brief Gives how long posted input took to show up on screen.
+         * 
+         * @return InputStats struct with the latencies
+         */
+        InputStats getInputStats();
+        /**
+         * @brief Starts or stops keeping every change of buttons held, along with the
+         * cycle it happened on, for getInputLog().
+         * 
+         * @param enabled true to record
+         */
+        void setInputRecording(bool enabled);
+        /**
+         * @brief Gives the input recorded so far, which replays the same through
+         * queueInput().
+         * 
+         * @return recorded events, in order
+         */
+        const std::vector<JoypadEvent>& getInputLog();
         Regval8 readMem(Regval16 addr); 
+        /**
+         * @brief Enables a signal on this machine so that it can be raised by its modules.
+         * 
+         * @param mask signal(s) to enable
+         */
+        void enableSignal(Regval16 mask);
+        /**
+         * @brief Checks and clears a signal raised by this machine.
+         * 
+         * @param mask signal(s) of interest
+         * 
+         * @return true if any of the signals were raised, false if they weren't
+         */
+        bool signalRaised(Regval16 mask);
+        /**
+         * @brief Enables or disables pacing emulation to real time.
+         * 
+         * @param enabled false to run as fast as the host allows
+         */
+        void setFrameLimit(bool enabled);
+        /**
+         * @brief Sets how fast emulation runs relative to real time.
+         * 
+         * @param mode 1x, 2x, 4x, or uncapped, which presents only once per host refresh
+         */
+        void setSpeed(SpeedMode mode);
+        SpeedMode getSpeed();
+        /**
+         * @brief Sets how many frames are run without drawing after each one drawn,
+         * keeping their timing and interrupts.
+         * 
+         * @param frames frames to skip, or FRAMESKIP_AUTO to follow how busy the host is
+         */
+        void setFrameSkip(int frames);
+        /**
+         * @brief Gives how steadily frames have been paced to real time.
+         * 
+         * @return pacing stats since pacing was last enabled
+         */
+        PacerStats getPacerStats();
+        /**
+         * @brief Sets the refresh rate of the host display, which uncapped speed
+         * publishes frames at.
+         * 
+         * @param rate refresh rate in Hz
+         */
+        void setRefreshRate(double rate);
+        /**
+         * @brief Sets where finished frames go. With none set they're thrown away
+         * without being drawn, which is all a headless run needs.
+         * 
+         * @param sink sink to hand frames to, or nullptr for none
+         */
+        void setFrameSink(FrameSink* sink);
 };
 #endif
\ No newline at end of file
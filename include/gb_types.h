@@ -13,4 +13,8 @@ constexpr Regval8 LCD_STAT_INT = 0x02;
 constexpr Regval8 TIMER_INT = 0x04;
 constexpr Regval8 SERIAL_INT = 0x08;
 constexpr Regval8 JOYPAD_INT = 0x10;
+constexpr Regval8 ALL_INTS = 0x1F;
+
+//Returned by modules that have no upcoming event
+constexpr int NO_EVENT = -1;
 #endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef INTERRUPTS_H
+#define INTERRUPTS_H
+#include "memory.h"
+
+//ISRs are laid out one after another in interrupt priority order
+constexpr Regval16 ISR_SPACING = 0x08;
+
+/**
+ * @brief Handle on the interrupt flags of a machine. IE & IF is kept cached on the
+ * Bus, so checking for a pending interrupt comes down to testing one byte.
+ * Components raise and clear interrupts through this instead of writing IF, and
+ * writes to IF or IE through the bus must be followed by refresh().
+ */
+class Interrupts{
+    private:
+        Bus& bus;
+
+    public:
+        Interrupts(Bus& bus);
+        /**
+         * @brief Requests interrupts by setting their bits in IF.
+         *
+         * @param mask interrupt(s) to request
+         */
+        void raise(Regval8 mask);
+        /**
+         * @brief Acknowledges interrupts by clearing their bits in IF.
+         *
+         * @param mask interrupt(s) to clear
+         */
+        void clear(Regval8 mask);
+        /**
+         * @brief Recomputes the cached state after IF or IE changed behind its back.
+         */
+        void refresh();
+        /**
+         * @brief Gives the interrupts that are both requested and enabled.
+         *
+         * @return IE & IF
+         */
+        Regval8 pending() const;
+        /**
+         * @brief Gives the pending interrupt with the highest priority.
+         *
+         * @return mask of the interrupt, 0 if none is pending
+         */
+        Regval8 highestPending() const;
+        /**
+         * @brief Gives the ISR of an interrupt.
+         *
+         * @param mask a single interrupt
+         *
+         * @return address the CPU jumps to for it
+         */
+        static Regval16 isrAddress(Regval8 mask);
+};
+
+inline Regval8 Interrupts::pending() const{
+    return bus.pendingInts;
+}
+#endif
@@ -0,0 +1,99 @@
+#ifndef JIT_H
+#define JIT_H
+#include "memory.h"
+#include "cpu.h"
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#ifdef USE_JIT
+//Size of the executable buffer, everything compiled is dropped once it fills up
+constexpr size_t JIT_CODE_SIZE = 4 * 1024 * 1024;
+//Times a run of code is entered before it gets compiled
+constexpr int JIT_HOT_THRESHOLD = 16;
+//Shortest run worth leaving the interpreter for
+constexpr int JIT_MIN_RUN_OPS = 2;
+constexpr int JIT_MAX_RUN_OPS = 32;
+//Direct-mapped table of recently entered runs, checked before the hash map
+constexpr int JIT_RECENT_RUNS = 1024;
+
+typedef void (*NativeRun)(Regval8* regs);
+
+typedef struct JitRun{
+    NativeRun code;         //nullptr until compiled, or if nothing here can be
+    uint32_t hits;
+    bool compilable;
+    uint8_t length;         //bytes of SM83 code covered
+    uint8_t mCycles;        //M-cycles the interpreter would have taken
+    Regval8 lastOpcode;
+    Regval8 lastCbOp;
+}JitRun;
+
+/**
+ * @brief Translates hot straight-line runs of ROM code into x86-64 machine code.
+ * Only instructions that work on registers alone are compiled, so a run never
+ * touches the bus, can't be changed by the code it runs, and takes a fixed
+ * number of M-cycles. Everything else is left to the interpreter.
+ */
+class Jit{
+    private:
+        Memory<SYS_PERM> mem;
+        Bus& bus;
+        uint8_t* codeBuf;
+        size_t codeUsed;
+        std::unordered_map<uint32_t, JitRun> runs;
+        struct RecentRun{
+            uint32_t key;
+            JitRun* run;
+        };
+        std::array<RecentRun, JIT_RECENT_RUNS> recent;
+        std::vector<uint8_t> out;
+
+        static const std::array<uint8_t, 256> flagsFromAH;
+        static std::array<uint8_t, 256> buildFlagsFromAH();
+        static int opLength(Regval8 opcode);
+        void compile(JitRun& run, Regval16 addr, Regval16 regionEnd);
+        void setWritable(bool writable);
+        void freeCode();
+        bool emitOp(Regval8 opcode, const Regval8* operands);
+        bool emitCbOp(Regval8 cbOp);
+        void emit(std::initializer_list<uint8_t> bytes);
+        void emitAluReg(uint8_t ext, RegIndex_8 dst, RegIndex_8 src);
+        void emitAluImm(uint8_t ext, RegIndex_8 dst, Regval8 imm);
+        void emitCarryIn();
+        void emitFlagsFromAH(Regval8 keep, Regval8 set, Regval8 force);
+        void emitFlagsFromScratch(Regval8 keep, Regval8 force);
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param bus bus state of the machine whose code gets compiled
+         */
+        Jit(Bus& bus);
+        ~Jit();
+        Jit(const Jit&) = delete;
+        Jit& operator=(const Jit&) = delete;
+        /**
+         * @brief Gives the compiled run starting at an address, counting the visit
+         * towards compiling it if it isn't yet.
+         *
+         * @param addr address of the first instruction, normally the program counter
+         *
+         * @return compiled run, or nullptr if the interpreter has to take this one
+         */
+        const JitRun* lookup(Regval16 addr);
+        /**
+         * @brief Runs a compiled run on the CPU's registers and moves the program
+         * counter past it. Cycle counts and peripherals are left to the caller.
+         *
+         * @param run compiled run, as given by lookup()
+         * @param cpu CPU whose registers the run works on
+         */
+        void execute(const JitRun* run, CPU& cpu);
+        /**
+         * @brief Drops all compiled code, e.g. after loading another game.
+         */
+        void flush();
+};
+#endif
+#endif
@@ -0,0 +1,100 @@
+#ifndef JOYPAD_H
+#define JOYPAD_H
+#include "memory.h"
+#include "interrupts.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+//JOYP bits selecting which half of the buttons shows up in the low nibble, active low
+constexpr Regval8 PAD_SELECT_MASK = 0x10;
+constexpr Regval8 BUTTON_SELECT_MASK = 0x20;
+//All buttons released
+constexpr Regval8 JOYPAD_RELEASED = 0xFF;
+
+/**
+ * @brief Buttons held from an emulated cycle on, as a mask of the *_MASK bits
+ * from memory.h cleared for every button held.
+ */
+typedef struct JoypadEvent{
+    uint64_t cycle;
+    Regval8 state;
+}JoypadEvent;
+
+/**
+ * @brief The joypad and the JOYP register. Input arrives as a queue of events,
+ * each applied on the exact cycle it is stamped with, so recorded input replays
+ * the same way no matter how often it is fed in or how the machine is stepped.
+ * The interrupt is requested only when a line of JOYP goes from high to low.
+ */
+class Joypad{
+    private:
+        Memory<JOYPAD_PERM> mem;
+        Register joypReg;
+        Interrupts interrupts;
+        std::deque<JoypadEvent> events;
+        //cycles emulated so far, the same count as the cycle of the machine
+        uint64_t cycle;
+        Regval8 state;
+        Regval8 select;
+        Regval8 lines;
+
+        void updateLines();
+        void applyDue();
+    public:
+        Joypad(Bus& bus);
+        /**
+         * @brief Queues a change of buttons held. Events must be queued in order,
+         * one stamped before the last one queued is moved up to it.
+         *
+         * @param cycle emulated cycle the change happens on, changes stamped in the
+         * past happen on the next cycle
+         *
+         * @param state buttons held from then on
+         *
+         * @return cycle the change was queued on, after being moved up
+         */
+        uint64_t queueEvent(uint64_t cycle, Regval8 state);
+        /**
+         * @brief Gives the buttons held once every queued event has been applied.
+         *
+         * @return joypad state
+         */
+        Regval8 getQueuedState();
+        void emulateCycle();
+        /**
+            @brief Runs the joypad for several cycles at once. Equivalent to calling
+            emulateCycle() n times.
+
+            @param n number of cycles to run
+        */
+        void emulateCycles(int n);
+        /**
+            @brief Gives the number of cycles before the next queued event is applied.
+
+            @return cycles until the next event, or NO_EVENT if none is queued
+        */
+        int cyclesUntilEvent();
+        /**
+         * @brief Reads input recorded by saveInputLog().
+         *
+         * @param file path of the log
+         *
+         * @return events in the log
+         *
+         * @throws std::invalid_argument if the log can't be opened or isn't
+         * all "cycle state" pairs
+         */
+        static std::vector<JoypadEvent> loadInputLog(std::string file);
+        /**
+         * @brief Writes input out as text, one "cycle state" pair per line.
+         *
+         * @param file path of the log
+         *
+         * @param log events to write
+         *
+         * @return true if the log was written, false if it couldn't be
+         */
+        static bool saveInputLog(std::string file, const std::vector<JoypadEvent>& log);
+};
+#endif
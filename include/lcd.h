@@ -2,10 +2,14 @@
 #define LCD_H
 #include <cstdint>
 #include <memory.h>
+#include <array>
 
 constexpr int SCREEN_WIDTH = 160, SCREEN_HEIGHT = 144;
 constexpr int SCAN_WIDTH = 210, SCAN_HEIGHT = 154;
 
+//A frame as shown, one ARGB8888 pixel per dot, row by row
+typedef std::array<uint32_t, SCREEN_WIDTH * SCREEN_HEIGHT> FrameBuffer;
+
 
 //LCDC MASKS
 typedef enum ControlBitIndex{
@@ -0,0 +1,211 @@
+#ifndef MBC_H
+#define MBC_H
+#include "memory.h"
+#include <array>
+#include <memory>
+
+//Header byte giving the size of cartridge RAM
+constexpr Regval16 RAM_SIZE_BYTE_ADDR = 0x0149;
+
+constexpr int MBC2_RAM_SIZE = 512;
+constexpr int NUM_RTC_REGS = 5;
+//The RTC runs on emulated time, so it keeps pace with the game at any speed
+constexpr uint64_t RTC_CYCLES_PER_SECOND = 4194304;
+//Registers, then latched registers, 4 bytes each, then a 64-bit UNIX timestamp.
+//Older saves have a 32-bit timestamp.
+constexpr size_t RTC_TRAILER_SIZE = 48;
+constexpr size_t RTC_OLD_TRAILER_SIZE = 44;
+
+/**
+ * @brief Memory bank controller of a cartridge. Writes to 0x0000-0x7FFF land on
+ * its registers, after which it works out the banks now switched in and has the
+ * Bus remap them, so reads from ROM and plain cart RAM never go through it. Cart
+ * RAM only comes through here while it is disabled or isn't plain memory.
+ */
+class Mbc{
+    protected:
+        Bus& bus;
+        bool ramEnabled;
+        int romBank0;
+        int romBankN;
+        int ramBank;
+
+        /**
+         * @brief Hands the banks selected by the registers to the Bus.
+         */
+        void remap();
+        /**
+         * @brief Tells whether cart RAM currently behaves as plain memory.
+         *
+         * @return false if RAM accesses have side effects, e.g. RTC registers
+         */
+        virtual bool ramIsPlain() const;
+        size_t ramOffset(Regval16 addr) const;
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param bus bus state of the machine the cartridge is plugged into
+         */
+        Mbc(Bus& bus);
+        virtual ~Mbc();
+        /**
+         * @brief Creates the controller named by a cartridge type and switches in
+         * its initial banks.
+         *
+         * @param bus bus state of the machine the cartridge is plugged into
+         *
+         * @param type cartridge type byte from the header
+         *
+         * @return controller for the cartridge
+         */
+        static std::unique_ptr<Mbc> create(Bus& bus, Regval8 type);
+        /**
+         * @brief Handles a write to the controller's registers.
+         *
+         * @param addr address between 0x0000 and 0x7FFF
+         *
+         * @param byte data written
+         */
+        virtual void writeRegister(Regval16 addr, Regval8 byte) = 0;
+        /**
+         * @brief Reads cart RAM that isn't mapped as plain memory.
+         *
+         * @param addr address between 0xA000 and 0xBFFF
+         *
+         * @return byte read, 0xFF while RAM is disabled
+         */
+        virtual Regval8 readRam(Regval16 addr);
+        /**
+         * @brief Writes cart RAM that isn't mapped as plain memory.
+         *
+         * @param addr address between 0xA000 and 0xBFFF
+         *
+         * @param byte data written, dropped while RAM is disabled
+         */
+        virtual void writeRam(Regval16 addr, Regval8 byte);
+        /**
+         * @brief Gives the size of the state the controller keeps after cart RAM in
+         * save files.
+         *
+         * @return size in bytes, 0 if there's nothing to keep
+         */
+        virtual size_t getTrailerSize() const;
+        /**
+         * @brief Restores controller state from the trailer of a save file.
+         *
+         * @param trailer first byte after cart RAM
+         *
+         * @param size bytes of trailer in the file, less than getTrailerSize() if it
+         * was written in an older format
+         */
+        virtual void loadTrailer(const Regval8* trailer, size_t size);
+        /**
+         * @brief Writes controller state to the trailer of a save file.
+         *
+         * @param trailer first byte after cart RAM, getTrailerSize() bytes long
+         */
+        virtual void saveTrailer(Regval8* trailer);
+        /**
+         * @brief Tells whether the game has changed state kept in the trailer since
+         * the last saveTrailer(), in a way the passing of time alone won't redo.
+         *
+         * @return true if the trailer needs saving
+         */
+        virtual bool trailerChanged() const;
+};
+
+//No controller at all, any RAM is always accessible
+class RomOnlyMbc : public Mbc{
+    public:
+        RomOnlyMbc(Bus& bus);
+        void writeRegister(Regval16 addr, Regval8 byte) override;
+};
+
+/**
+ * @brief MBC1, up to 2 MiB of ROM and 32 KiB of RAM. In advanced banking mode
+ * the upper bank bits also switch the 0x0000 area and the RAM bank. Multicart
+ * boards (MBC1M) wire the upper bits one position lower and are detected by a
+ * second Nintendo logo at bank 0x10.
+ */
+class Mbc1 : public Mbc{
+    private:
+        Regval8 bank1;
+        Regval8 bank2;
+        BankingMode mode;
+        bool multicart;
+
+        void updateBanks();
+    public:
+        Mbc1(Bus& bus);
+        void writeRegister(Regval16 addr, Regval8 byte) override;
+};
+
+/**
+ * @brief MBC2, up to 256 KiB of ROM and 512 half-bytes of built-in RAM. Bit 8 of
+ * the address picks between the RAM enable and ROM bank registers.
+ */
+class Mbc2 : public Mbc{
+    protected:
+        bool ramIsPlain() const override;
+    public:
+        Mbc2(Bus& bus);
+        void writeRegister(Regval16 addr, Regval8 byte) override;
+        Regval8 readRam(Regval16 addr) override;
+        void writeRam(Regval16 addr, Regval8 byte) override;
+};
+
+/**
+ * @brief MBC3, up to 2 MiB of ROM and 32 KiB of RAM, plus the RTC registers that
+ * can be selected in place of a RAM bank on carts with a timer. Reads see the
+ * registers as of the last latch.
+ *
+ * The clock isn't ticked. The registers are brought up to date from the cycles
+ * emulated since they last were, only when they are latched, written or saved.
+ * While the emulator isn't running, time is taken from the host clock instead,
+ * through the timestamp in the save file.
+ */
+class Mbc3 : public Mbc{
+    private:
+        bool timer;
+        Regval8 ramSelect;
+        Regval8 lastLatchWrite;
+        std::array<Regval8, NUM_RTC_REGS> rtcRegs;
+        std::array<Regval8, NUM_RTC_REGS> rtcLatched;
+        //cycle rtcRegs are up to date as of
+        uint64_t rtcCycle;
+        bool rtcWritten;
+        //cycle and host time of the last saveTrailer()
+        uint64_t savedCycle;
+        uint64_t savedTime;
+
+        bool rtcSelected() const;
+        uint64_t currentCycle() const;
+        void updateRtc();
+        void advanceRtc(uint64_t seconds);
+    protected:
+        bool ramIsPlain() const override;
+    public:
+        Mbc3(Bus& bus, bool timer);
+        void writeRegister(Regval16 addr, Regval8 byte) override;
+        Regval8 readRam(Regval16 addr) override;
+        void writeRam(Regval16 addr, Regval8 byte) override;
+        size_t getTrailerSize() const override;
+        void loadTrailer(const Regval8* trailer, size_t size) override;
+        void saveTrailer(Regval8* trailer) override;
+        bool trailerChanged() const override;
+};
+
+/**
+ * @brief MBC5, up to 8 MiB of ROM over a 9-bit bank number and 128 KiB of RAM.
+ * Unlike the others, bank 0 can be switched into the 0x4000 area. On rumble carts
+ * bit 3 of the RAM bank drives the motor instead.
+ */
+class Mbc5 : public Mbc{
+    private:
+        bool rumble;
+    public:
+        Mbc5(Bus& bus, bool rumble);
+        void writeRegister(Regval16 addr, Regval8 byte) override;
+};
+#endif
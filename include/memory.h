@@ -2,10 +2,15 @@
 #define MEMORY_H
 
 #include "gb_types.h"
+#include "rom_image.h"
+#include "cart_ram.h"
 #include <cstdint>
 #include <cstddef>
 #include <array>
 #include <string>
+#include <vector>
+#include <memory>
+#include <functional>
 
 //Write Permissions
 typedef enum Perm{
@@ -14,7 +19,8 @@ typedef enum Perm{
     DMA_PERM,
     SYS_PERM,
     COUNTER_PERM,
-    OAM_PERM
+    OAM_PERM,
+    JOYPAD_PERM
 }Permission;
 
 //Access Types
@@ -23,6 +29,13 @@ typedef enum Access{
     WRITE
 }Access;
 
+//Parts of the bus the CPU is kept off of while the PPU or DMA uses them
+typedef enum BusLock{
+    VRAM_LOCK = 0x01,
+    OAM_LOCK = 0x02,
+    DMA_LOCK = 0x04
+}BusLock;
+
 //Cartridge Types
 typedef enum CartType{
     ROM_ONLY,
@@ -40,7 +53,13 @@ typedef enum CartType{
     MBC3_TIMER_RAM_BATTERY,
     MBC3,
     MBC3_RAM,
-    MBC3_RAM_BATTERY
+    MBC3_RAM_BATTERY,
+    MBC5 = 0x19,
+    MBC5_RAM,
+    MBC5_RAM_BATTERY,
+    MBC5_RUMBLE,
+    MBC5_RUMBLE_RAM,
+    MBC5_RUMBLE_RAM_BATTERY
 }CartType;
 
 //Banking Modes
@@ -74,6 +93,9 @@ constexpr Regval16 ROM_BANK_N_END = 0x7FFF;
 constexpr Regval16 RAM_BANK_START = 0xA000;
 constexpr Regval16 RAM_BANK_END = 0xBFFF;
 
+constexpr Regval16 WRAM_START = 0xC000;
+constexpr Regval16 WRAM_END = 0xDFFF;
+
 constexpr Regval16 ECHO_START = 0xE000;
 constexpr Regval16 ECHO_END = 0xFDFF;
 
@@ -83,6 +105,9 @@ constexpr Regval16 BAD_ZONE_END = 0xFEFF;
 constexpr Regval16 OAM_START = 0xFE00;
 constexpr Regval16 OAM_END = 0xFE9F;
 
+constexpr Regval16 IO_START = 0xFF00;
+constexpr Regval16 IO_END = 0xFF7F;
+
 constexpr Regval16 HRAM_START = 0xFF80;
 constexpr Regval16 HRAM_END = 0xFFFE;
 
@@ -147,29 +172,133 @@ constexpr Regval8 ALL_PAD_MASK = 0xF0;
 
 constexpr int RAM_BANK_BANK_SIZE = 8192;
 constexpr int ROM_BANK_SIZE = 16384;
-constexpr int MBC1_NUM_RAM_BANKS = 4;
-constexpr int MBC1_NUM_ROM_BANKS = 128;
+constexpr int CODE_PAGE_SIZE = 16;
+//What the CPU reads from a part of the bus it is locked out of
+constexpr Regval8 LOCKED_READ = 0xFF;
+//Granularity of the read/write page tables
+constexpr int MEM_PAGE_SIZE = 256;
+constexpr int NUM_MEM_PAGES = (UINT16_MAX + 1) / MEM_PAGE_SIZE;
+//Write hooks are indexed from IO_START, which takes in IE at the very top
+constexpr int NUM_IO_HOOKS = UINT16_MAX - IO_START + 1;
+
+//Called with the new value right after a register has been written
+typedef std::function<void(Regval8 byte)> IoWriteHook;
+
+class Mbc;
+
+/**
+ * @brief All bus, cartridge and signal state belonging to a single machine. Every
+ * Memory handle of a Gameboy references the same Bus, so separate Gameboy instances
+ * never share an address space.
+ */
+typedef struct Bus{
+    std::array<Regval8,UINT16_MAX+1> mem;
+    //Cartridge RAM, sized from the header
+    std::unique_ptr<CartRam> cartRam;
+    //Cartridge ROM, romBanks points into it one bank at a time
+    std::shared_ptr<const RomImage> rom;
+    std::vector<const Regval8*> romBanks;
+    //Banks switched in by the MBC, along with whether cart RAM can be accessed
+    //as plain memory. Otherwise cart RAM accesses are left to the MBC.
+    int romBank0;
+    int currRomBank;
+    int currRamBank;
+    bool ramMapped;
+    std::unique_ptr<Mbc> mbc;
+    CartType cartType;
+    Regval16 signalFlags;
+    Regval16 signalEnable;
+    //BusLock flags set by the PPU and DMA, only CPU accesses honour them
+    Regval8 cpuLocks;
+    //IE & IF, kept current by Interrupts so the CPU only has to test this
+    Regval8 pendingInts;
+    //When set, called before the CPU touches VRAM, OAM or I/O registers so that
+    //peripherals running behind the CPU can catch up first.
+    std::function<void(Regval16 addr, Access acc)> syncPeripherals;
+    //When set, gives the number of cycles emulated so far, for clocks on the cartridge
+    std::function<uint64_t()> cycleCount;
+    //Pages of WRAM and HRAM holding cached code, writing to one sets codeWritten
+    std::array<bool, (UINT16_MAX + 1) / CODE_PAGE_SIZE> codePages;
+    bool codeWritten;
+    //Where plain reads and writes of each page land. A nullptr page has side effects
+    //(MBC registers, I/O, peripheral catch-up, ...) and goes through the slow path.
+    std::array<const Regval8*, NUM_MEM_PAGES> readPages;
+    std::array<Regval8*, NUM_MEM_PAGES> writePages;
+    //Components to notify when an I/O register or IE is written
+    std::array<IoWriteHook, NUM_IO_HOOKS> ioWriteHooks;
+
+    Bus();
+    ~Bus();
+    Bus(const Bus&) = delete;
+    Bus& operator=(const Bus&) = delete;
+    /**
+     * @brief Rebuilds the page tables from scratch.
+     */
+    void mapPages();
+    /**
+     * @brief Remaps only the ROM and cartridge RAM pages, which is all a bank switch
+     * or RAM enable can change.
+     */
+    void mapBanks();
+    /**
+     * @brief Stores a byte to cartridge RAM, mapping its page for writing if
+     * this is the first store to it since the last flush.
+     * 
+     * @param offset offset into cartridge RAM
+     * 
+     * @param byte data written
+     */
+    void writeCartRam(size_t offset, Regval8 byte);
+    /**
+     * @brief Sends writes to the page holding addr down the slow path, so that
+     * writes to cached code are noticed.
+     *
+     * @param addr address of cached code
+     */
+    void unmapCodePage(Regval16 addr);
+    /**
+     * @brief Forgets all cached code pages and puts their writes back on the fast path.
+     */
+    void clearCodePages();
+    /**
+     * @brief Gives the start of a ROM bank. Banks the cartridge doesn't have read as 0.
+     *
+     * @param bank bank number
+     *
+     * @return first byte of the bank
+     */
+    const Regval8* getRomBank(int bank) const;
+}Bus;
 
+/**
+ * @brief A component's handle on the bus. The permission decides at compile time
+ * what each access goes through:
+ * CPU_PERM - peripheral catch-up, echo/unusable area checks, and the VRAM, OAM and
+ * DMA locks the PPU and DMA put on the CPU.
+ * SYS_PERM - the same minus the locks, for the emulator itself and debugging.
+ * DMA_PERM - reads go through banking with no checks, writes are plain stores.
+ * PPU_PERM, OAM_PERM, COUNTER_PERM, JOYPAD_PERM - plain loads and stores, for VRAM,
+ * OAM and I/O only.
+ */
+template<Permission perm>
 class Memory{
     private:
-        static std::array<Regval8,UINT16_MAX+1> mem;
-        static std::array<std::array<Regval8, RAM_BANK_BANK_SIZE>, MBC1_NUM_RAM_BANKS> ramBanks;
-        static std::array<std::array<Regval8, ROM_BANK_SIZE>, MBC1_NUM_ROM_BANKS> romBanks;
-        static const Regval8 numRamBanks;
-        static const Regval8 numRomBanks;
-        static Regval8 currRamBank;
-        static Regval8 currRomBank;
-        static bool ramEnabled;
-        static Regval8 joypadBuff;
-        static BankingMode mode;
-        static CartType cartType;
-        const Permission perm;
+        Bus& bus;
 
         bool inRange(const Regval16 addr, const Regval16 low, const Regval16 hi) const;
+        void saveTrailer();
         bool checkPerm(const Regval16 addr, Access acc) const;
-        void prepJoypadRead(const Regval8 byte) const;
+        bool lockedOut(const Regval16 addr) const;
+        void syncPeripherals(const Regval16 addr, Access acc) const;
+        bool writeSlow(const Regval16 addr, const Regval8 byte) const;
+        Regval8 readSlow(const Regval16 addr) const;
     public:
-    Memory(Permission perm);
+    /**
+     * @brief Constructor
+     * 
+     * @param bus bus state of the machine this handle belongs to
+     */
+    Memory(Bus& bus);
     /**
      * @brief writes a byte to specified address in memory.
      * 
@@ -199,27 +328,13 @@ class Memory{
      */
         Regval16 dump(const Regval16 addr, const Regval8* buf, const size_t n) const;
     /**
-     * @brief dumps n bytes from buf, starting from addr in memory
-     * 
-     * @param addr starting point of dump
+     * @brief Maps a cartridge ROM into the address space, with bank 1 switched in.
      * 
-     * @param n number of bytes to dump
-     * 
-     * @return number of bytes written 
+     * @param rom image of the ROM, kept alive for as long as it is mapped
      */
-        Regval16 copyRomBank(const Regval8* buf, const int bankNum);
+        void mapRom(std::shared_ptr<const RomImage> rom);
     /**
-     * @brief dumps n bytes from buf, starting from addr in memory
-     * 
-     * @param addr starting point of dump
-     * 
-     * @param n number of bytes to dump
-     * 
-     * @return number of bytes written 
-     */
-        Regval16 copyRamBank(const Regval8* buf, const int bankNum);
-    /**
-     * @brief forbids all but HRAM accesses for the CPU. Only Memory instances with the DMA perm can do this.
+     * @brief forbids all but HRAM and I/O accesses for the CPU. Only Memory instances with the DMA perm can do this.
      * 
      * @return true if lock is successful, false if it isn't.
      */
@@ -241,9 +356,20 @@ class Memory{
      * 
      * @return true if lock is successful, false if it isn't.
      */
-        
-        void setJoypadBuff(Regval8 byte);
-        Regval8 getJoypadBuff();
+        bool unlockVram();
+    /**
+     * @brief forbids OAM accesses for the CPU. Only Memory instances with the PPU perm can use this.
+     * 
+     * @return true if lock is successful, false if it isn't.
+     */
+        bool lockOam();
+    /**
+     * @brief allows OAM accesses for the CPU. Only Memory instances with the PPU perm can use this.
+     * 
+     * @return true if lock is successful, false if it isn't.
+     */
+        bool unlockOam();
+
     /**
      * @brief Gives caller a reference to a location in memory. Should only be used by modules to gain
      * quick access to their respective I/O registers.
@@ -251,9 +377,97 @@ class Memory{
      * @return reference to requested memory location
      */
         Register getRegister(Regval16 addr);
+    /**
+     * @brief Has a handler called every time an I/O register or IE is written through
+     * the bus, so that its owner can react to the write instead of polling for it.
+     * Handlers registered on the same register are called in registration order.
+     * 
+     * @param addr address of the register, between IO_START and IO_END or IE_REG_ADDR
+     * 
+     * @param hook handler taking the value written
+     */
+        void onWrite(Regval16 addr, IoWriteHook hook);
         void saveRamState(std::string file);
+    /**
+     * @brief Fills cartridge RAM from a save file, along with any MBC state kept
+     * after it. A file of a different size than the RAM fills as much of it as
+     * both have.
+     * 
+     * @param file path of the save file
+     * 
+     * @return true if the file could be read, false if it couldn't
+     */
+        bool loadRamState(std::string file);
+    /**
+     * @brief Backs cartridge RAM with a save file, so that every write to RAM
+     * ends up in the file. The file is created if it doesn't exist.
+     * 
+     * @param file path of the save file
+     * 
+     * @return true if the file is mapped, false if there's no RAM or it couldn't be
+     */
+        bool mapRamState(std::string file);
+    /**
+     * @brief Hands the RAM written to since the last call to the thread writing
+     * the save file out to disk. Never blocks.
+     */
+        void flushRamState();
+    /**
+     * @brief Writes a mapped save file out to disk, waiting for it to finish.
+     * 
+     * @return true if RAM is mapped onto a save file, false if there's nothing to sync
+     */
+        bool syncRamState();
+    /**
+     * @brief Sets up the memory bank controller and cartridge RAM named by the header
+     * of the mapped ROM. Throws if the controller isn't supported.
+     */
         void resolveCartridgeType();
-        bool unlockVram();
         void printStatus();
 };
+
+/*
+Plain page-table accesses are inlined into the callers, the rest goes through
+readSlow() and writeSlow(). For the PPU, OAM, counters and joypad not even the
+page table is looked at, they only ever touch VRAM, OAM and I/O registers.
+*/
+template<Permission perm>
+inline Regval8 Memory<perm>::read(const Regval16 addr) const{
+    if constexpr(perm == PPU_PERM || perm == OAM_PERM || perm == COUNTER_PERM || perm == JOYPAD_PERM){
+        return bus.mem[addr];
+    }
+    else{
+        //the DMA is kept in lockstep with the CPU while active, so its lock is current here
+        if constexpr(perm == CPU_PERM){
+            if((bus.cpuLocks & DMA_LOCK) && addr < IO_START)
+                return LOCKED_READ;
+        }
+        const Regval8* page = bus.readPages[addr / MEM_PAGE_SIZE];
+        if(page){
+            return page[addr % MEM_PAGE_SIZE];
+        }
+        return readSlow(addr);
+    }
+}
+
+template<Permission perm>
+inline bool Memory<perm>::write(const Regval16 addr, const Regval8 byte) const{
+    if constexpr(perm == PPU_PERM || perm == OAM_PERM || perm == COUNTER_PERM || perm == JOYPAD_PERM ||
+        perm == DMA_PERM){
+        bus.mem[addr] = byte;
+        return true;
+    }
+    else{
+        if constexpr(perm == CPU_PERM){
+            if((bus.cpuLocks & DMA_LOCK) && addr < IO_START)
+                return false;
+        }
+        Regval8* page = bus.writePages[addr / MEM_PAGE_SIZE];
+        if(page){
+            page[addr % MEM_PAGE_SIZE] = byte;
+            return true;
+        }
+        return writeSlow(addr, byte);
+    }
+}
 #endif
\ No newline at end of file
@@ -23,7 +23,7 @@ constexpr Regval8 OBJECT_SIZE = 4;
 
 class OAM{
     private:
-        Memory mem; 
+        Memory<OAM_PERM> mem; 
         std::vector<Object> visibleObjs;
         Register lcdcReg;
 
@@ -31,7 +31,7 @@ class OAM{
         void checkBit(Regval8 val, Regval8 index);
         
     public:
-        OAM();
+        OAM(Bus& bus);
         Object popObj();
         Regval8 getMinX();
         Regval8 searchLine(const Regval8 lineNum);
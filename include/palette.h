@@ -32,13 +32,14 @@ class Palette{
         std::array<uint32_t, 4>obp0;
         std::array<uint32_t, 4>obp1;
 
-        Memory mem;
+        Memory<PPU_PERM> mem;
         Register bgpReg;
         Register obp0Reg;
         Register obp1Reg;
 
         uint32_t convertColor(Regval8 color);
+        void updatePalette(std::array<uint32_t, 4>& colors, Regval8 regVal);
     public:
-        Palette();
+        Palette(Bus& bus);
         uint32_t getColor(PaletteSelect select, PaletteIndex index);
 };
\ No newline at end of file
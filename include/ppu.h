@@ -1,10 +1,12 @@
 #ifndef PPU_H
 #define PPU_H
 #include "memory.h"
-#include "SDL2/SDL.h"
 #include "fetcher.h"
 #include "lcd.h"
 #include "signal.h"
+#include "interrupts.h"
+#include "frame_pacer.h"
+#include "frame_sink.h"
 #include <queue>
 #include <chrono>
 #include <thread>
@@ -29,12 +31,20 @@ constexpr Regval8 STAT_LYC_FLAG_MASK = 0x04;
 constexpr int CYCLES_PER_LINE = 456;
 constexpr int OAM_CYCLES = 20;
 
-constexpr int WIN_DIMENSION_SCALE_FACTOR = 2;
+typedef enum SpeedMode{
+    SPEED_1X,       //real time
+    SPEED_2X,
+    SPEED_4X,
+    SPEED_UNCAPPED  //as fast as the host allows, presenting once per host refresh
+}SpeedMode;
+
+//Frame skip setting that picks how many frames to skip from how busy the host is
+constexpr int FRAMESKIP_AUTO = -1;
 
 class PPU{
     private:
         Signal signal;
-        Memory mem;
+        Memory<PPU_PERM> mem;
         Fetcher fetcher;
         OAM oam;
         Palette palette;
@@ -42,7 +52,7 @@ class PPU{
         State state;
 
         Register lcdcReg;
-        Register intFlagReg;
+        Interrupts interrupts;
         Register lyReg;
         Register statReg;
         Register lycReg;
@@ -50,6 +60,8 @@ class PPU{
         Register winXReg;
 
         bool drawingWindow;
+        //LCD enable bit of LCDC, updated on writes
+        bool lcdOn;
 
         Regval8 trashPixelCount;
 
@@ -58,27 +70,121 @@ class PPU{
         int cyclesLeft;
         int numFrames; 
 
-        SDL_Window* window;
-        SDL_Surface* windowSurface;
-        SDL_Renderer* renderer; 
-        SDL_Texture* frameTexture;
-        Uint32 frameBuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
-        std::chrono::high_resolution_clock::time_point lastFrameTime;
+        //where frames go when no sink is set
+        NullFrameSink nullSink;
+        FrameSink* sink;
+        //buffer the sink gave for the frame being drawn
+        uint32_t* frameBuffer;
+        FramePacer pacer;
+        //paces presents to the host display when frames aren't paced at all
+        FramePacer presentPacer;
+        std::chrono::high_resolution_clock::time_point presentTime;
+        bool frameLimit;
+        SpeedMode speed;
+        //frames run without writing pixels, as set and as currently used when automatic
+        int frameSkip;
+        int skipCount;
+        int skippedInGroup;
+        bool skippingFrame;
+        //host time spent running the frames of the current group, outside of pacing waits
+        std::chrono::steady_clock::time_point frameStart;
+        std::chrono::steady_clock::time_point groupStart;
+        std::chrono::steady_clock::duration groupBusy;
 
         void runFSM();
         void updateDisplay();
+        bool skipNextFrame();
+        void adaptSkipCount();
         uint32_t resolveColor(PaletteIndex color);
         void prepLine();
         void prepWindowLine();
         void prepSpriteFetch();
         void drawPixel(GbPixel pixel);
         void changeStatMode(State state);
+        void lockCpuOut();
+        int skipIdleCycles(int n);
     public:
-        PPU();
-        ~PPU();
+        PPU(Bus& bus);
 
         void emulateCycle();
+        /**
+            @brief Runs the PPU for several cycles at once. Equivalent to calling
+            emulateCycle() n times, as long as LCDC doesn't change in between.
+
+            @param n number of cycles to run
+        */
+        void emulateCycles(int n);
+        /**
+            @brief Gives a lower bound on the number of cycles before the PPU changes
+            mode or LY. Exact outside of pixel transfer, where sprite and window fetches
+            can only make the mode last longer.
+
+            @return cycles until the next mode or LY change, or NO_EVENT if the LCD is off
+        */
+        int cyclesUntilEvent();
         void printStatus();
+        /**
+            @brief Enables or disables pacing the display to FRAME_RATE.
+
+            @param enabled false to run frames as fast as possible
+        */
+        void setFrameLimit(bool enabled);
+        /**
+            @brief Sets how fast frames are paced relative to real time. Uncapped runs
+            frames as fast as they come but only presents the latest one each refresh
+            of the host display.
+
+            @param mode speed to run at
+        */
+        void setSpeed(SpeedMode mode);
+        SpeedMode getSpeed();
+        /**
+            @brief Sets how many frames are skipped after each one drawn. Skipped frames
+            run with full timing and interrupts, only their pixels aren't written or
+            presented. Uncapped speed ignores this and skips every frame that would end
+            before the host display is due another.
+
+            @param skip frames to skip, or FRAMESKIP_AUTO to skip more while the host
+            can't keep up and fewer once it can
+        */
+        void setFrameSkip(int skip);
+        /**
+            @brief Sets the refresh rate of the display frames end up on, which uncapped
+            speed publishes frames at.
+
+            @param rate refresh rate in Hz
+        */
+        void setRefreshRate(double rate);
+        /**
+            @brief Sets where finished frames go.
+
+            @param sink sink to hand frames to, or nullptr to throw them away
+        */
+        void setFrameSink(FrameSink* sink);
+        /**
+            @brief Tells whether finished frames go anywhere they're looked at.
+
+            @return false if frames are thrown away without being drawn
+        */
+        bool showsFrames();
+        /**
+            @brief Gives the number of frames handed to the frame sink so far.
+
+            @return frame count
+        */
+        int getFrameCount();
+        /**
+            @brief Gives the time the last frame was handed to the frame sink at.
+
+            @return time of the last frame submitted
+        */
+        std::chrono::high_resolution_clock::time_point getPresentTime();
+        /**
+            @brief Gives how steadily frames have been paced since pacing was last enabled.
+
+            @return pacing stats
+        */
+        PacerStats getPacerStats();
         
 };
 #endif
\ No newline at end of file
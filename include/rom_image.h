@@ -0,0 +1,90 @@
+#ifndef ROM_IMAGE_H
+#define ROM_IMAGE_H
+#include "gb_types.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+//Header byte giving the ROM size as 32 KiB shifted left by its value
+constexpr Regval16 ROM_SIZE_BYTE_ADDR = 0x0148;
+
+/**
+ * @brief Read-only image of a cartridge ROM file. The file is memory-mapped, so
+ * its pages are only read in as they are touched and are shared with every other
+ * process mapping the same file. Files that don't end on a bank boundary are
+ * read into memory instead, padded out to a whole bank.
+ * 
+ * Images are normally obtained through open(), which hands every instance
+ * loading the same ROM contents the same image.
+ */
+class RomImage{
+    private:
+        const Regval8* bytes;
+        size_t size;
+        int numBanks;
+        //set when the file is mapped, holds the file otherwise
+        void* mapping;
+        std::vector<Regval8> buffer;
+        uint64_t hash;
+
+        //Images in use anywhere in the process, keyed on content hash
+        static std::mutex cacheLock;
+        static std::unordered_map<uint64_t, std::vector<std::weak_ptr<const RomImage>>> cache;
+
+        void readFile(const std::string& filename);
+        bool sameContents(const RomImage& other) const;
+        static int headerBankCount(Regval8 sizeCode);
+    public:
+        /**
+         * @brief Gives the image of a ROM file, shared with every other user of a
+         * ROM with the same contents, under any filename. The image is released
+         * once its last user lets go of it.
+         *
+         * @param filename path of the .gb file
+         *
+         * @return shared image of the ROM
+         */
+        static std::shared_ptr<const RomImage> open(const std::string& filename);
+        /**
+         * @brief Constructor
+         *
+         * @param filename path of the .gb file
+         */
+        RomImage(const std::string& filename);
+        ~RomImage();
+        RomImage(const RomImage&) = delete;
+        RomImage& operator=(const RomImage&) = delete;
+        /**
+         * @brief Gives the start of a 16 KiB bank.
+         *
+         * @param bank bank number
+         *
+         * @return first byte of the bank, or nullptr if the file doesn't reach it
+         */
+        const Regval8* getBank(int bank) const;
+        /**
+         * @brief Gives the number of banks, taken from the cartridge header unless
+         * the file itself holds more.
+         *
+         * @return number of 16 KiB banks
+         */
+        int getNumBanks() const;
+        /**
+         * @brief Gives the size of the image.
+         *
+         * @return size in bytes, padded to a whole number of banks
+         */
+        size_t getSize() const;
+        /**
+         * @brief Gives a 64-bit FNV-1a style hash of the image, taken a word rather
+         * than a byte at a time, padding included.
+         *
+         * @return content hash
+         */
+        uint64_t getHash() const;
+};
+#endif
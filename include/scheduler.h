@@ -0,0 +1,69 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <queue>
+
+constexpr uint64_t NEVER = UINT64_MAX;
+
+typedef enum EventType{
+    PPU_MODE_EVENT,
+    DIV_INC_EVENT,
+    TIMA_OVERFLOW_EVENT,
+    DMA_EVENT,
+    JOYPAD_EVENT,
+    NUM_EVENT_TYPES
+}EventType;
+
+typedef struct Event{
+    uint64_t time;
+    EventType type;
+}Event;
+
+/**
+ * @brief Min-heap of upcoming peripheral events, keyed on the absolute cycle they
+ * happen at. Each event type has at most one live deadline, rescheduling a type
+ * leaves its old heap entry behind to be dropped once it reaches the top.
+ */
+class Scheduler{
+    private:
+        struct Later{
+            bool operator()(const Event& e1, const Event& e2) const;
+        };
+        std::priority_queue<Event, std::vector<Event>, Later> events;
+        std::array<uint64_t, NUM_EVENT_TYPES> deadlines;
+
+        void dropStale();
+    public:
+        Scheduler();
+        /**
+         * @brief Sets the deadline of an event type, replacing any previous one.
+         * 
+         * @param type event of interest
+         * 
+         * @param time absolute cycle the event happens at
+         */
+        void schedule(EventType type, uint64_t time);
+        /**
+         * @brief Removes the deadline of an event type.
+         * 
+         * @param type event of interest
+         */
+        void cancel(EventType type);
+        /**
+         * @brief Gives the absolute cycle of the earliest pending event.
+         * 
+         * @return cycle of the next event, or NEVER if nothing is scheduled
+         */
+        uint64_t nextEventTime();
+        /**
+         * @brief Gives the deadline of a single event type.
+         * 
+         * @param type event of interest
+         * 
+         * @return cycle the event happens at, or NEVER if it isn't scheduled
+         */
+        uint64_t getDeadline(EventType type);
+};
+#endif
\ No newline at end of file
@@ -14,14 +14,13 @@ constexpr Regval16 ALL_SIGNALS = 0x0F;
 
 class Signal{
     private:
-        static Regval16 flags;
-        static Regval16 flagEnable;
+        Bus& bus;
 
         void clearSignal(Regval16 mask);
         bool checkFlag(Regval16 mask);
     
     public:
-        Signal();
+        Signal(Bus& bus);
 
         void raiseSignal(Regval16 mask);
 
@@ -0,0 +1,74 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+//Keeps the two indices on separate cache lines so the threads don't bounce one between them
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Bounded lock-free queue between exactly one producer thread and one consumer
+ * thread. Neither side ever blocks, a full queue refuses the push.
+ *
+ * @tparam T type of the items, copied in and out
+ *
+ * @tparam N capacity, a power of two
+ */
+template<typename T, size_t N>
+class SpscQueue{
+    static_assert(N && !(N & (N - 1)), "SpscQueue capacity must be a power of two.");
+    private:
+        std::array<T, N> slots;
+        //next slot to pop, only written by the consumer
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+        //next slot to push, only written by the producer
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+    public:
+        SpscQueue();
+        /**
+         * @brief Adds an item. Only to be called by the producer.
+         *
+         * @param item item to add
+         *
+         * @return true if added, false if the queue is full
+         */
+        bool push(const T& item);
+        /**
+         * @brief Takes the oldest item. Only to be called by the consumer.
+         *
+         * @param item set to the item taken
+         *
+         * @return true if an item was taken, false if the queue is empty
+         */
+        bool pop(T& item);
+};
+
+template<typename T, size_t N>
+SpscQueue<T, N>::SpscQueue() : head(0), tail(0){
+}
+
+template<typename T, size_t N>
+bool SpscQueue<T, N>::push(const T& item){
+    size_t pos = tail.load(std::memory_order_relaxed);
+    if(pos - head.load(std::memory_order_acquire) == N){
+        return false;
+    }
+    slots[pos % N] = item;
+    //publishes the slot along with the new tail
+    tail.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T, size_t N>
+bool SpscQueue<T, N>::pop(T& item){
+    size_t pos = head.load(std::memory_order_relaxed);
+    if(pos == tail.load(std::memory_order_acquire)){
+        return false;
+    }
+    item = slots[pos % N];
+    //hands the slot back to the producer only once it has been read
+    head.store(pos + 1, std::memory_order_release);
+    return true;
+}
+#endif
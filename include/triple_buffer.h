@@ -0,0 +1,89 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+#include "spsc_queue.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//Set in the shared slot index while it holds a buffer the consumer hasn't taken yet
+constexpr uint8_t TRIPLE_BUFFER_FRESH = 0x4;
+
+/**
+ * @brief Lock-free hand-off of whole buffers from one producer thread to one consumer
+ * thread. The producer fills the back buffer and publishes it, the consumer takes the
+ * latest published one as its front buffer. The third buffer sits in between, so
+ * neither side ever waits on the other and the consumer always gets the newest buffer,
+ * any published in between being dropped.
+ *
+ * Buffers are reused rather than cleared, the back buffer holds whatever was last
+ * written to it.
+ *
+ * @tparam T type of the buffers
+ */
+template<typename T>
+class TripleBuffer{
+    private:
+        std::unique_ptr<T[]> slots;
+        //only touched by the producer
+        alignas(CACHE_LINE_SIZE) uint8_t back;
+        //the buffer in between, with TRIPLE_BUFFER_FRESH if published and not taken
+        alignas(CACHE_LINE_SIZE) std::atomic<uint8_t> middle;
+        //only touched by the consumer
+        alignas(CACHE_LINE_SIZE) uint8_t front;
+    public:
+        TripleBuffer();
+        /**
+         * @brief Gives the buffer to fill. Only to be called by the producer.
+         *
+         * @return back buffer
+         */
+        T& getBack();
+        /**
+         * @brief Hands the back buffer to the consumer and takes another to fill.
+         * Only to be called by the producer.
+         */
+        void publish();
+        /**
+         * @brief Takes the latest published buffer, if there's one not taken yet.
+         * Only to be called by the consumer.
+         *
+         * @return true if the front buffer was replaced
+         */
+        bool fetch();
+        /**
+         * @brief Gives the buffer last taken. Only to be called by the consumer.
+         *
+         * @return front buffer
+         */
+        const T& getFront();
+};
+
+template<typename T>
+TripleBuffer<T>::TripleBuffer() : slots(new T[3]()), back(0), middle(1), front(2){
+}
+
+template<typename T>
+T& TripleBuffer<T>::getBack(){
+    return slots[back];
+}
+
+template<typename T>
+void TripleBuffer<T>::publish(){
+    //releases the writes to the buffer along with it
+    back = middle.exchange(back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel) & ~TRIPLE_BUFFER_FRESH;
+}
+
+template<typename T>
+bool TripleBuffer<T>::fetch(){
+    if(!(middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH)){
+        return false;
+    }
+    front = middle.exchange(front, std::memory_order_acq_rel) & ~TRIPLE_BUFFER_FRESH;
+    return true;
+}
+
+template<typename T>
+const T& TripleBuffer<T>::getFront(){
+    return slots[front];
+}
+#endif
@@ -1,5 +1,6 @@
 #define SDL_MAIN_HANDLED 1
 #include "debugger.h"
+#include "display.h"
 #include "signal.h"
 #include <stdio.h>
 #include <sstream>
@@ -41,6 +42,8 @@ using namespace std;
 int main(int numArgc, char** argv){
     SDL_Init(SDL_INIT_EVERYTHING);
     Gameboy gb;
+    Display display;
+    gb.setFrameSink(&display);
     try{
         gb.loadGame(argv[1]);
     }
@@ -57,6 +60,7 @@ int main(int numArgc, char** argv){
     cout << "Welcome to the JK EMU Debugger." << endl;
     //runtime phase
     while(true){ 
+        display.present();
         if(!handleEvent()){
             SDL_Quit();
             return 0;
@@ -2,16 +2,30 @@
 #include <stdio.h>
 #include "SDL2/SDL.h"
 #include "gameboy.h"
+#include "display.h"
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <memory>
+#include <algorithm>
 
 using namespace std;
 
 
-int handleEvent(SDL_Event* event, Gameboy& gb);
+int handleEvent(SDL_Event* event, Regval8& buttons, SpeedMode& speed);
+int pumpEvents(Gameboy& gb, Regval8& buttons, atomic<int>& speed, bool replaying);
+void runEmulation(Gameboy& gb, atomic<bool>& running, atomic<int>& speed, long maxFrames, int& result);
 void handleJoypadEvent(SDL_KeyboardEvent* key);
 string omitFileExt(const std::string& filepath);
+bool parseSpeed(const string& arg, SpeedMode& speed);
+bool parseFrameSkip(const string& arg, int& frames);
 int timedPollEvent();
 
 constexpr int EVENT_POLLS_PER_SEC = 100;
+//How long the render loop naps when there's neither a new frame nor an event
+constexpr chrono::milliseconds RENDER_IDLE_SLEEP(1);
 
 
 typedef enum EventResult{
@@ -21,46 +35,162 @@ typedef enum EventResult{
 
 
 int main(int argc, char** argv){
-    SDL_Init(SDL_INIT_EVERYTHING);
-    SDL_SetHint(SDL_HINT_WINDOWS_DISABLE_THREAD_NAMING, "1");
-    Signal signal;
-    signal.enableSignal(FRAME_SIGNAL);
+    //headless runs never bring SDL up, so they work without a display
+    bool headless = find(argv, argv + argc, string("--headless")) != argv + argc;
     Gameboy gb;
+    unique_ptr<Display> display;
+    if(!headless){
+        SDL_Init(SDL_INIT_EVERYTHING);
+        //after the window is gone, which outlives everything else in main
+        atexit(SDL_Quit);
+        SDL_SetHint(SDL_HINT_WINDOWS_DISABLE_THREAD_NAMING, "1");
+        display.reset(new Display());
+        gb.setFrameSink(display.get());
+        if(display->getRefreshRate()){
+            gb.setRefreshRate(display->getRefreshRate());
+        }
+    }
+    gb.enableSignal(FRAME_SIGNAL);
+    //input is kept with the cycle it landed on, so a recording replays exactly
+    string recordFile;
+    bool replaying = false;
+    long maxFrames = 0;
+    Regval8 buttons = JOYPAD_RELEASED;
+    //a bad game or bad argument ends things before anything runs
     try{
         gb.loadGame(argv[1]);
         gb.loadSram(omitFileExt(argv[1]) + ".sav");
+        for(int i = 2; i < argc; i++){
+            if(string(argv[i]) == "--instruction-step"){
+                gb.setRunMode(INSTRUCTION_STEP);
+            }
+            else if(string(argv[i]) == "--jit"){
+                gb.setRunMode(INSTRUCTION_STEP);
+                gb.setJitEnabled(true);
+            }
+            else if(string(argv[i]) == "--record-input" && i + 1 < argc){
+                recordFile = argv[++i];
+                gb.setInputRecording(true);
+            }
+            else if(string(argv[i]) == "--speed" && i + 1 < argc){
+                SpeedMode speed;
+                if(!parseSpeed(argv[++i], speed)){
+                    cout << "--speed takes 1, 2, 4, or uncapped" << endl;
+                    return 1;
+                }
+                gb.setSpeed(speed);
+            }
+            else if(string(argv[i]) == "--frameskip" && i + 1 < argc){
+                int frames;
+                if(!parseFrameSkip(argv[++i], frames)){
+                    cout << "--frameskip takes a frame count or auto" << endl;
+                    return 1;
+                }
+                gb.setFrameSkip(frames);
+            }
+            else if(string(argv[i]) == "--frames" && i + 1 < argc){
+                maxFrames = atol(argv[++i]);
+            }
+            else if(string(argv[i]) == "--replay-input" && i + 1 < argc){
+                for(JoypadEvent event : Joypad::loadInputLog(argv[++i])){
+                    gb.queueInput(event.cycle, event.state);
+                }
+                replaying = true;
+            }
+        }
     }
     catch(std::exception&e){
         cout << e.what();
         return 1;
     }
-    while(true){ 
-        if(signal.signalRaised(FRAME_SIGNAL)){
-            SDL_Event event;
-            if(SDL_PollEvent(&event) && handleEvent(&event, gb) == QUIT){
-                gb.saveSram(omitFileExt(argv[1]) + ".sav"); 
-                SDL_Quit();
-                return 0; 
+    atomic<bool> running(true);
+    atomic<int> speed(gb.getSpeed());
+    int result = 0;
+    if(headless){
+        runEmulation(gb, running, speed, maxFrames, result);
+    }
+    else{
+        //this thread keeps the window, the machine runs on its own
+        thread emulation(runEmulation, ref(gb), ref(running), ref(speed), maxFrames, ref(result));
+        while(running){
+            if(pumpEvents(gb, buttons, speed, replaying) == QUIT){
+                running = false;
+            }
+            else if(!display->present()){
+                this_thread::sleep_for(RENDER_IDLE_SLEEP);
             }
         }
-        try{
-            gb.emulateCycle();
+        emulation.join();
+    }
+    if(result == 0){
+        gb.saveSram(omitFileExt(argv[1]) + ".sav");
+        if(!recordFile.empty()){
+            if(!Joypad::saveInputLog(recordFile, gb.getInputLog())){
+                cout << "Could not write input log to " << recordFile << endl;
+                result = 1;
+            }
         }
-        catch(std::exception&e){
-            cout << e.what();
-            return 1;
+    }
+    return result;
+}
+
+/*
+Steps the machine until told to stop, it has run maxFrames frames (if not 0), or
+it throws. Only this thread touches the machine, apart from postInput() and the
+frame sink, so speed changes are handed over and applied here between frames.
+*/
+void runEmulation(Gameboy& gb, atomic<bool>& running, atomic<int>& speed, long maxFrames, int& result){
+    long numFrames = 0;
+    try{
+        while(running.load(memory_order_relaxed)){
+            if(gb.signalRaised(FRAME_SIGNAL)){
+                if(maxFrames && ++numFrames >= maxFrames){
+                    running = false;
+                    break;
+                }
+                if(speed.load(memory_order_relaxed) != gb.getSpeed()){
+                    gb.setSpeed((SpeedMode)speed.load(memory_order_relaxed));
+                }
+            }
+            gb.step();
         }
     }
+    catch(std::exception&e){
+        cout << e.what();
+        result = 1;
+        running = false;
+    }
 }
 
-int handleEvent(SDL_Event* event, Gameboy& gb){
+/*
+SDL only hands out events on the thread that made the window, so they're drained
+by the render loop and handed to the machine through postInput(), which is safe
+from here. A replay ignores the buttons but can still be sped up.
+*/
+int pumpEvents(Gameboy& gb, Regval8& buttons, atomic<int>& speed, bool replaying){
+    SDL_Event event;
+    while(SDL_PollEvent(&event)){
+        Regval8 held = buttons;
+        SpeedMode requested = (SpeedMode)speed.load();
+        if(handleEvent(&event, buttons, requested) == QUIT){
+            return QUIT;
+        }
+        speed = requested;
+        if(buttons != held && !replaying){
+            gb.postInput(buttons);
+        }
+    }
+    return CONTINUE;
+}
+
+int handleEvent(SDL_Event* event, Regval8& buttons, SpeedMode& speed){
     switch(event->type){
         case SDL_QUIT:
             return QUIT;
         case SDL_KEYDOWN:
         case SDL_KEYUP:
             SDL_KeyboardEvent keyEvent = event->key;
-            Regval8 currState = gb.getJoypad();
+            Regval8 currState = buttons;
             Regval8 newState;
             switch(keyEvent.keysym.sym){
                 case SDLK_a:
@@ -127,6 +257,13 @@ int handleEvent(SDL_Event* event, Gameboy& gb){
                         newState = currState | START_BUTTON_MASK;
                     }
                     break;
+                case SDLK_TAB:
+                    //1x, 2x, 4x, uncapped, then back to 1x
+                    if(keyEvent.type == SDL_KEYDOWN && !keyEvent.repeat){
+                        speed = (SpeedMode)((speed + 1) % (SPEED_UNCAPPED + 1));
+                    }
+                    newState = currState;
+                    break;
                 case SDLK_ESCAPE:
                     if(keyEvent.type == SDL_KEYDOWN){
                         newState = currState & ~ALL_BUTTON_MASK;
@@ -139,11 +276,48 @@ int handleEvent(SDL_Event* event, Gameboy& gb){
                     newState = currState;
                     break;
             }
-            gb.setJoypad(newState); 
+            buttons = newState;
     }
     return CONTINUE;
 }
 
+bool parseSpeed(const string& arg, SpeedMode& speed){
+    if(arg == "1"){
+        speed = SPEED_1X;
+    }
+    else if(arg == "2"){
+        speed = SPEED_2X;
+    }
+    else if(arg == "4"){
+        speed = SPEED_4X;
+    }
+    else if(arg == "uncapped"){
+        speed = SPEED_UNCAPPED;
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+//Counts too big for an int are turned down rather than wrapped or thrown on
+bool parseFrameSkip(const string& arg, int& frames){
+    if(arg == "auto"){
+        frames = FRAMESKIP_AUTO;
+        return true;
+    }
+    if(arg.empty() || arg.find_first_not_of("0123456789") != string::npos){
+        return false;
+    }
+    errno = 0;
+    long count = strtol(arg.c_str(), nullptr, 10);
+    if(errno == ERANGE || count > INT_MAX){
+        return false;
+    }
+    frames = (int)count;
+    return true;
+}
+
 string omitFileExt(const std::string& filepath){
     size_t periodPos = filepath.find_last_of('.');
     if(periodPos == string::npos){
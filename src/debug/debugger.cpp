@@ -9,14 +9,14 @@ void Debugger::runToBreakpoint(){
     while(true){
         Regval16 addr = gb.emulateCycle();
         std::vector<Regval16>::iterator it = std::find(breakPts.begin(), breakPts.end(), addr);
-        if(it != breakPts.end() || signal.signalRaised(ALL_SIGNALS)){
+        if(it != breakPts.end() || gb.signalRaised(ALL_SIGNALS)){
             break;
         }
     }
 }
 
 void Debugger::enableSignal(Regval16 mask){
-    signal.enableSignal(mask);
+    gb.enableSignal(mask);
 }
 
 void Debugger::runToSignal(){
@@ -0,0 +1,179 @@
+#include "block_cache.h"
+#include "instructions.h"
+
+/*
+Only the instruction bytes are cached, timing is still left to the
+M-cycle handlers. That keeps every bus access of an instruction on the
+cycle it always happened on, while opcode and operand fetches from
+cached code skip the bus entirely.
+*/
+
+const std::array<uint8_t, 256> BlockCache::opLengths = BlockCache::buildOpLengths();
+const std::array<bool, 256> BlockCache::blockEnds = BlockCache::buildBlockEnds();
+
+std::array<uint8_t, 256> BlockCache::buildOpLengths(){
+    std::array<uint8_t, 256> table;
+    table.fill(1);
+    const Regval8 imm8[] = {
+        LD_B_IMM, LD_C_IMM, LD_D_IMM, LD_E_IMM, LD_H_IMM, LD_L_IMM, LD_A_IMM, LD_HL_IMM_IND,
+        LDH_IMM_A, LDH_A_IMM, ADD_IMM, ADC_IMM, SUB_IMM, SBC_IMM, AND_IMM, XOR_IMM, OR_IMM, CP_IMM,
+        ADD_SP_IMM, LD_HL_SP_OFFSET, JR, JR_Z, JR_NZ, JR_C, JR_NC, CB_OP
+    };
+    const Regval8 imm16[] = {
+        LD_BC_IMM, LD_DE_IMM, LD_HL_IMM, LD_SP_IMM, LD_ADDR_A, LD_A_ADDR, LD_DIR_SP,
+        JP, JP_Z, JP_NZ, JP_C, JP_NC, CALL, CALL_Z, CALL_NZ, CALL_C, CALL_NC
+    };
+    for(Regval8 op : imm8){
+        table[op] = 2;
+    }
+    for(Regval8 op : imm16){
+        table[op] = 3;
+    }
+    return table;
+}
+
+std::array<bool, 256> BlockCache::buildBlockEnds(){
+    std::array<bool, 256> table;
+    table.fill(false);
+    const Regval8 ends[] = {
+        JR, JR_Z, JR_NZ, JR_C, JR_NC, JP, JP_Z, JP_NZ, JP_C, JP_NC, JP_HL,
+        CALL, CALL_Z, CALL_NZ, CALL_C, CALL_NC, RET, RET_Z, RET_NZ, RET_C, RET_NC, RETI,
+        RST_0x00, RST_0x08, RST_0x10, RST_0x18, RST_0x20, RST_0x28, RST_0x30, RST_0x38,
+        HALT, STOP
+    };
+    for(Regval8 op : ends){
+        table[op] = true;
+    }
+    //opcodes with no instruction behind them end a block too
+    const Regval8 invalid[] = {0xD3, 0xDB, 0xDD, 0xE3, 0xE4, 0xEB, 0xEC, 0xED, 0xF4, 0xFC, 0xFD};
+    for(Regval8 op : invalid){
+        table[op] = true;
+    }
+    return table;
+}
+
+BlockCache::BlockCache(Bus& bus) : bus(bus), mem(bus){
+    curr = nullptr;
+    currEnd = nullptr;
+    currBank = 0;
+    recent.fill({0, nullptr});
+}
+
+//Cartridge RAM, VRAM, OAM and I/O can change under the CPU's feet and aren't cached
+bool BlockCache::inRegion(Regval16 addr, Regval16& regionEnd){
+    if(addr <= ROM_BANK_0_END){
+        regionEnd = ROM_BANK_0_END;
+    }
+    else if(addr <= ROM_BANK_N_END){
+        regionEnd = ROM_BANK_N_END;
+    }
+    else if(addr >= WRAM_START && addr <= WRAM_END){
+        regionEnd = WRAM_END;
+    }
+    else if(addr >= HRAM_START && addr <= HRAM_END){
+        regionEnd = HRAM_END;
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+int BlockCache::bankOf(Regval16 addr){
+    if(addr <= ROM_BANK_0_END){
+        return bus.romBank0;
+    }
+    if(addr <= ROM_BANK_N_END){
+        return bus.currRomBank;
+    }
+    return 0;
+}
+
+std::vector<DecodedOp> BlockCache::decode(Regval16 addr, Regval16 regionEnd){
+    std::vector<DecodedOp> block;
+    bool ram = addr > ROM_BANK_N_END;
+    while((int)block.size() < MAX_BLOCK_OPS){
+        DecodedOp op;
+        op.pc = addr;
+        op.bytes[0] = mem.read(addr);
+        op.length = opLengths[op.bytes[0]];
+        //an instruction straddling the end of the region is left to the bus
+        if(regionEnd - addr + 1 < op.length){
+            break;
+        }
+        for(int i = 1; i < op.length; i++){
+            op.bytes[i] = mem.read(addr + i);
+        }
+        if(ram){
+            for(int i = 0; i < op.length; i++){
+                bus.codePages[(addr + i) / CODE_PAGE_SIZE] = true;
+                bus.unmapCodePage(addr + i);
+            }
+        }
+        block.push_back(op);
+        if(blockEnds[op.bytes[0]] || regionEnd - addr + 1 == op.length){
+            break;
+        }
+        addr += op.length;
+    }
+    return block;
+}
+
+void BlockCache::flushRam(){
+    for(uint32_t key : ramBlocks){
+        blocks.erase(key);
+    }
+    ramBlocks.clear();
+    recent.fill({0, nullptr});
+    bus.clearCodePages();
+    curr = nullptr;
+}
+
+void BlockCache::flush(){
+    blocks.clear();
+    ramBlocks.clear();
+    recent.fill({0, nullptr});
+    bus.clearCodePages();
+    curr = nullptr;
+}
+
+const DecodedOp* BlockCache::fetch(Regval16 addr){
+    if(bus.codeWritten){
+        flushRam();
+    }
+    //straight-line execution just moves on to the next op of the block
+    if(curr){
+        const DecodedOp* next = curr + 1;
+        if(next != currEnd && next->pc == addr && currBank == bankOf(addr)){
+            curr = next;
+            return curr;
+        }
+    }
+    Regval16 regionEnd;
+    if(!inRegion(addr, regionEnd)){
+        curr = nullptr;
+        return nullptr;
+    }
+    int bank = bankOf(addr);
+    uint32_t key = ((uint32_t)bank << 16) | addr;
+    RecentBlock& slot = recent[addr % RECENT_BLOCKS];
+    if(!slot.ops || slot.key != key){
+        auto it = blocks.find(key);
+        if(it == blocks.end()){
+            it = blocks.emplace(key, decode(addr, regionEnd)).first;
+            if(addr > ROM_BANK_N_END){
+                ramBlocks.push_back(key);
+            }
+        }
+        slot = {key, &it->second};
+    }
+    const std::vector<DecodedOp>& ops = *slot.ops;
+    if(ops.empty()){
+        curr = nullptr;
+        return nullptr;
+    }
+    curr = ops.data();
+    currEnd = curr + ops.size();
+    currBank = bank;
+    return curr;
+}
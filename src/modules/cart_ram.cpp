@@ -0,0 +1,226 @@
+#include "cart_ram.h"
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CartRam::CartRam(size_t size) : size(size){
+    trailerSize = 0;
+    savedTrailerSize = 0;
+    mapping = nullptr;
+#ifdef _WIN32
+    file = nullptr;
+#endif
+    buffer.assign(size, 0);
+    bytes = buffer.data();
+    anyDirty = false;
+    anyPending = false;
+    stopping = false;
+}
+
+CartRam::CartRam(size_t size, const std::string& filename, size_t trailerSize) : CartRam(size){
+    size_t mappedSize = size + trailerSize;
+    if(!mappedSize){
+        return;
+    }
+    size_t fileSize = 0;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(handle == INVALID_HANDLE_VALUE){
+        return;
+    }
+    LARGE_INTEGER length;
+    if(GetFileSizeEx(handle, &length)){
+        fileSize = length.QuadPart;
+    }
+    //mapping more than the file holds grows it, zero filled
+    HANDLE view = CreateFileMappingA(handle, NULL, PAGE_READWRITE, 0, (DWORD)mappedSize, NULL);
+    if(view){
+        mapping = MapViewOfFile(view, FILE_MAP_WRITE, 0, 0, mappedSize);
+        CloseHandle(view);
+    }
+    if(!mapping){
+        CloseHandle(handle);
+        return;
+    }
+    file = handle;
+#else
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0){
+        return;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || ((size_t)info.st_size < mappedSize && ftruncate(fd, mappedSize) != 0)){
+        ::close(fd);
+        return;
+    }
+    fileSize = info.st_size;
+    void* addr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED){
+        return;
+    }
+    mapping = addr;
+#endif
+    buffer.clear();
+    buffer.shrink_to_fit();
+    bytes = (Regval8*)mapping;
+    this->trailerSize = trailerSize;
+    savedTrailerSize = fileSize > size ? std::min(fileSize - size, trailerSize) : 0;
+    size_t numPages = (mappedSize + CART_RAM_PAGE_SIZE - 1) / CART_RAM_PAGE_SIZE;
+    dirty.assign(numPages, false);
+    pending.assign(numPages, false);
+    flusher = std::thread(&CartRam::flushLoop, this);
+}
+
+CartRam::~CartRam(){
+    if(!mapping){
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    flusher.join();
+    sync();
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+    CloseHandle(file);
+#else
+    munmap(mapping, size + trailerSize);
+#endif
+}
+
+/*
+The lock is only held to take the batch, never while writing it out, so
+handOff() practically always gets it on the first try.
+*/
+void CartRam::flushLoop(){
+    std::vector<bool> pages(pending.size(), false);
+    std::unique_lock<std::mutex> guard(lock);
+    while(true){
+        wake.wait(guard, [this]{
+            return anyPending || stopping;
+        });
+        if(!anyPending){
+            return;
+        }
+        pages.swap(pending);
+        anyPending = false;
+        guard.unlock();
+        flushPages(pages);
+        std::fill(pages.begin(), pages.end(), false);
+        guard.lock();
+    }
+}
+
+//Runs of dirty pages are flushed in one go, widened to whole pages of the OS
+void CartRam::flushPages(const std::vector<bool>& pages){
+#ifdef _WIN32
+    const size_t osPage = 4096;
+#else
+    const size_t osPage = sysconf(_SC_PAGESIZE);
+#endif
+    size_t page = 0;
+    while(page < pages.size()){
+        if(!pages[page]){
+            page++;
+            continue;
+        }
+        size_t runEnd = page;
+        while(runEnd < pages.size() && pages[runEnd]){
+            runEnd++;
+        }
+        size_t start = page * CART_RAM_PAGE_SIZE / osPage * osPage;
+        size_t end = std::min(runEnd * CART_RAM_PAGE_SIZE, size + trailerSize);
+#ifdef _WIN32
+        FlushViewOfFile(bytes + start, end - start);
+#else
+        msync(bytes + start, end - start, MS_SYNC);
+#endif
+        page = runEnd;
+    }
+#ifdef _WIN32
+    FlushFileBuffers(file);
+#endif
+}
+
+Regval8* CartRam::data(){
+    return bytes;
+}
+
+Regval8& CartRam::operator[](size_t offset){
+    return bytes[offset];
+}
+
+size_t CartRam::getSize() const{
+    return size;
+}
+
+bool CartRam::empty() const{
+    return size == 0;
+}
+
+bool CartRam::isMapped() const{
+    return mapping != nullptr;
+}
+
+Regval8* CartRam::getTrailer(){
+    return mapping && trailerSize ? bytes + size : nullptr;
+}
+
+size_t CartRam::getSavedTrailerSize() const{
+    return savedTrailerSize;
+}
+
+bool CartRam::isWritable(size_t offset) const{
+    return !mapping || dirty[offset / CART_RAM_PAGE_SIZE];
+}
+
+bool CartRam::markDirty(size_t offset){
+    if(!mapping || dirty[offset / CART_RAM_PAGE_SIZE]){
+        return false;
+    }
+    dirty[offset / CART_RAM_PAGE_SIZE] = true;
+    anyDirty = true;
+    return true;
+}
+
+bool CartRam::handOff(){
+    if(!anyDirty){
+        return false;
+    }
+    std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+    if(!guard.owns_lock()){
+        return false;
+    }
+    for(size_t page = 0; page < dirty.size(); page++){
+        if(dirty[page]){
+            pending[page] = true;
+            dirty[page] = false;
+        }
+    }
+    anyDirty = false;
+    anyPending = true;
+    guard.unlock();
+    wake.notify_one();
+    return true;
+}
+
+void CartRam::sync(){
+    if(!mapping){
+        return;
+    }
+#ifdef _WIN32
+    FlushViewOfFile(mapping, size + trailerSize);
+    FlushFileBuffers(file);
+#else
+    msync(mapping, size + trailerSize, MS_SYNC);
+#endif
+}
@@ -14,13 +14,13 @@ typedef enum InputClockSpeed{
     SPEED_3
 }InputClockSPEED;
 
-Counters::Counters() : 
-mem(COUNTER_PERM),
+Counters::Counters(Bus& bus) : 
+mem(bus),
 divReg(mem.getRegister(DIV_REG_ADDR)),
 timaReg(mem.getRegister(TIMA_REG_ADDR)),
 tmaReg(mem.getRegister(TMA_REG_ADDR)),
 tacReg(mem.getRegister(TAC_REG_ADDR)),
-intFlagReg(mem.getRegister(IF_REG_ADDR))
+interrupts(bus)
 {
     divReg = 0x18;
     timaReg = 0x00;
@@ -28,36 +28,49 @@ intFlagReg(mem.getRegister(IF_REG_ADDR))
     tacReg = 0xF8;
     divCycleCount = 0;
     timaCycleCount = 0;
+    updateTimerControl();
+    mem.onWrite(TAC_REG_ADDR, [this](Regval8){
+        updateTimerControl();
+    });
 }
 
-void Counters::emulateCycle(){
-    if(divCycleCount == DIV_CYCLES_PER_INC){
-        divReg++;
-        divCycleCount = 0;
-    }
-    else
-        divCycleCount++;
-    int intervalLen = 0;
+void Counters::updateTimerControl(){
+    intervalLen = getIntervalLen();
+    timerEnabled = tacReg & TIMER_ENABLE_MASK;
+}
+
+int Counters::getIntervalLen(){
+    int len = 0;
     switch(tacReg & INPUT_CLOCK_MASK){
         case SPEED_0:
-            intervalLen = 1024;
+            len = 1024;
             break;
         case SPEED_1:
-            intervalLen = 16;
+            len = 16;
             break;
         case SPEED_2:
-            intervalLen = 64;
+            len = 64;
             break;
         case SPEED_3:
-            intervalLen = 256;
+            len = 256;
             break;
         default: break;
     }
-    if(tacReg & TIMER_ENABLE_MASK){
+    return len;
+}
+
+void Counters::emulateCycle(){
+    if(divCycleCount == DIV_CYCLES_PER_INC){
+        divReg++;
+        divCycleCount = 0;
+    }
+    else
+        divCycleCount++;
+    if(timerEnabled){
         if(timaCycleCount == intervalLen){
             timaReg++;
             if(!timaReg){
-                intFlagReg |= TIMER_INT;
+                interrupts.raise(TIMER_INT);
                 timaReg = tmaReg;
             }
             timaCycleCount = 0;
@@ -65,4 +78,39 @@ void Counters::emulateCycle(){
         else
             timaCycleCount++;
     }
+}
+
+void Counters::emulateCycles(int n){
+    //each counter wraps after reaching its period, one cycle later than the period itself
+    int divCycles = divCycleCount + n;
+    divReg += divCycles / (DIV_CYCLES_PER_INC + 1);
+    divCycleCount = divCycles % (DIV_CYCLES_PER_INC + 1);
+    if(!timerEnabled)
+        return;
+    //a count left past a shorter interval never matches it again
+    if(timaCycleCount > intervalLen){
+        timaCycleCount += n;
+        return;
+    }
+    int timaCycles = timaCycleCount + n;
+    int numIncs = timaCycles / (intervalLen + 1);
+    timaCycleCount = timaCycles % (intervalLen + 1);
+    for(int i = 0; i < numIncs; i++){
+        timaReg++;
+        if(!timaReg){
+            interrupts.raise(TIMER_INT);
+            timaReg = tmaReg;
+        }
+    }
+}
+
+int Counters::cyclesUntilDivInc(){
+    return DIV_CYCLES_PER_INC - divCycleCount;
+}
+
+int Counters::cyclesUntilTimaOverflow(){
+    if(!timerEnabled || timaCycleCount > intervalLen){
+        return NO_EVENT;
+    }
+    return (intervalLen - timaCycleCount) + (UINT8_MAX - timaReg) * (intervalLen + 1);
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 #include <stdexcept>
 #include <iostream>
 
-CPU::CPU() : mem(CPU_PERM){
+CPU::CPU(Bus& bus) : mem(bus){
     regs_8[A] = 0x01;
     regs_8[B] = 0x00;
     regs_8[C] = 0x13;
@@ -15,69 +15,92 @@ CPU::CPU() : mem(CPU_PERM){
     regs_8[F] = 0x80;
     regs_16[PC] = 0x0100;
     regs_16[SP] = 0xFFFE;
+    regs_16[IX] = 0x0000;
+    regs_16[IY] = 0x0000;
+    lazy = {FLAGS_ADD, 0, 0, 0, 0, 0};
+}
+
+/*
+Most flags are overwritten before anything looks at them, so arithmetic only
+records its operands and result. F is brought up to date when it's read as a
+whole, and single flags are worked out on their own for conditions and
+carry-ins. Flags an op doesn't touch stay pending from the one before, unless
+the new op leaves some of them in place, in which case those are settled first.
+*/
+void CPU::deferFlags(FlagOp op, Regval16 a, Regval16 b, Regval8 carry, Regval8 result, Regval8 mask){
+    if(lazy.mask & ~mask){
+        resolveFlags();
+    }
+    lazy = {op, mask, a, b, carry, result};
 }
 
-bool CPU::fullCarry(Regval8 val1, Regval8 val2, Operation op, bool withCarry){
-    int res;
-    switch(op){
-        case ADD:
-            res = val1 + val2;
-            if((regs_8[F] & CARRY_FLAG) && withCarry){
-                res += 1;
-            }
-            if(res > UINT8_MAX){
-                return true;
-            }
+void CPU::setFlags(Regval8 mask, Regval8 flags){
+    if(lazy.mask & ~mask){
+        resolveFlags();
+    }
+    lazy.mask = 0;
+    regs_8[F] = (regs_8[F] & ~mask) | flags;
+}
+
+Regval8 CPU::computeFlags(){
+    Regval8 flags = 0;
+    switch(lazy.op){
+        case FLAGS_ADD:
+            if(lazy.result == 0)
+                flags |= ZERO_FLAG;
+            if((lazy.a & 0x0F) + (lazy.b & 0x0F) + lazy.carry > 0x0F)
+                flags |= HALF_CARRY_FLAG;
+            if(lazy.a + lazy.b + lazy.carry > 0xFF)
+                flags |= CARRY_FLAG;
             break;
-        case SUB:
-            res = val1 - val2;
-            if((regs_8[F] & CARRY_FLAG) && withCarry){
-                res -= 1;
-            }
-            if(res < 0){
-                return true;
-            }
+        case FLAGS_SUB:
+            flags |= SUBTRACT_FLAG;
+            if(lazy.result == 0)
+                flags |= ZERO_FLAG;
+            if((lazy.a & 0x0F) < (lazy.b & 0x0F) + lazy.carry)
+                flags |= HALF_CARRY_FLAG;
+            if(lazy.a < lazy.b + lazy.carry)
+                flags |= CARRY_FLAG;
+            break;
+        case FLAGS_ADD_16:
+            if((lazy.a & 0x0FFF) + (lazy.b & 0x0FFF) > 0x0FFF)
+                flags |= HALF_CARRY_FLAG;
+            if(lazy.a + lazy.b > 0xFFFF)
+                flags |= CARRY_FLAG;
             break;
     }
-    return false;
+    return flags;
 }
 
-bool CPU::halfCarry(Regval8 val1, Regval8 val2, Operation op, bool withCarry){
-    int res;
-    switch(op){
-        case ADD:
-            res = (val1 % 16) + (val2 % 16);
-            if(((regs_8[F] & CARRY_FLAG) > 0) && withCarry){
-                res += 1;
+void CPU::resolveFlags(){
+    if(lazy.mask){
+        regs_8[F] = (regs_8[F] & ~lazy.mask) | (computeFlags() & lazy.mask);
+        lazy.mask = 0;
+    }
+}
+
+bool CPU::getFlag(Regval8 flag){
+    if(!(lazy.mask & flag)){
+        return regs_8[F] & flag;
+    }
+    //conditions and carry-ins only ever need Z or C
+    switch(flag){
+        case ZERO_FLAG:
+            return lazy.result == 0;
+        case CARRY_FLAG:
+            switch(lazy.op){
+                case FLAGS_ADD:
+                    return lazy.a + lazy.b + lazy.carry > 0xFF;
+                case FLAGS_SUB:
+                    return lazy.a < lazy.b + lazy.carry;
+                case FLAGS_ADD_16:
+                    return lazy.a + lazy.b > 0xFFFF;
             }
-            if(res > 15)
-                return true;
             break;
-        case SUB:
-            res = (val1 % 16) - (val2 % 16);
-            if((regs_8[F] & CARRY_FLAG) && withCarry)
-                res -= 1;
-            if(res < 0)
-                return true; 
+        default:
             break;
     }
-    return false;
-}
-
-void CPU::addRegRegCarry(RegIndex_8 reg1, RegIndex_8 reg2){
-    Regval8 prev0 = regs_8[reg1];
-    Regval8 prev1 = regs_8[reg2];
-    regs_8[reg1] += regs_8[reg2];
-    regs_8[reg1] += regs_8[F] & CARRY_FLAG ? 1 : 0;
-    if(halfCarry(prev0, prev1, ADD, true))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(fullCarry(prev0, prev1, ADD, true)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    return computeFlags() & flag;
 }
 
 Regval16 CPU::getRegPair(RegIndex_8 msr, RegIndex_8 lsr){
@@ -111,138 +134,61 @@ void CPU::popPC(){
 }
 
 Regval8 CPU::addReg(RegIndex_8 reg){
-    if(fullCarry(regs_8[A], regs_8[reg], ADD, false))
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(regs_8[A], regs_8[reg], ADD, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    regs_8[A] += regs_8[reg];
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    Regval8 prev = regs_8[A];
+    Regval8 val = regs_8[reg];
+    regs_8[A] += val;
+    deferFlags(FLAGS_ADD, prev, val, 0, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::addIndirect(){
+    Regval8 prev = regs_8[A];
     Regval8 val = mem.read(getRegPair(H,L));
-    if(fullCarry(regs_8[A], val, ADD, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(regs_8[A], val, ADD, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
     regs_8[A] += val;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    deferFlags(FLAGS_ADD, prev, val, 0, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::addImm(Regval8 imm){
-    if(fullCarry(regs_8[A], imm, ADD, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(regs_8[A], imm, ADD, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    regs_8[A] += imm;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    Regval8 prev = regs_8[A];
+    Regval8 val = imm;
+    regs_8[A] += val;
+    deferFlags(FLAGS_ADD, prev, val, 0, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::addRegCarry(RegIndex_8 reg){
-    Regval8 prev0 = regs_8[A];
-    Regval8 prev1 = regs_8[reg];
-    regs_8[A] += regs_8[reg];
-    regs_8[A] += regs_8[F] & CARRY_FLAG ? 1 : 0;
-    if(halfCarry(prev0, prev1, ADD, true))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(fullCarry(prev0, prev1, ADD, true)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    Regval8 prev = regs_8[A];
+    Regval8 val = regs_8[reg];
+    Regval8 carry = getFlag(CARRY_FLAG) ? 1 : 0;
+    regs_8[A] += val + carry;
+    deferFlags(FLAGS_ADD, prev, val, carry, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::addIndirectCarry(){
     Regval8 prev = regs_8[A];
     Regval8 val = mem.read(getRegPair(H,L));
-    regs_8[A] += val;
-    regs_8[A] += regs_8[F] & CARRY_FLAG ? 1 : 0;
-    if(halfCarry(prev, val, ADD, true))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(fullCarry(prev, val, ADD, true)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    Regval8 carry = getFlag(CARRY_FLAG) ? 1 : 0;
+    regs_8[A] += val + carry;
+    deferFlags(FLAGS_ADD, prev, val, carry, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::addImmCarry(Regval8 imm){
     Regval8 prev = regs_8[A];
-    regs_8[A] += imm;
-    regs_8[A] += regs_8[F] & CARRY_FLAG ? 1 : 0;
-    if(halfCarry(prev, imm, ADD, true))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(fullCarry(prev, imm, ADD, true)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    Regval8 val = imm;
+    Regval8 carry = getFlag(CARRY_FLAG) ? 1 : 0;
+    regs_8[A] += val + carry;
+    deferFlags(FLAGS_ADD, prev, val, carry, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::subReg(RegIndex_8 reg){
     Regval8 prev = regs_8[A];
-    regs_8[A] -= regs_8[reg];
-    if(fullCarry(prev, regs_8[reg], SUB, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(prev, regs_8[reg], SUB, false)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    Regval8 val = regs_8[reg];
+    regs_8[A] -= val;
+    deferFlags(FLAGS_SUB, prev, val, 0, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
@@ -250,172 +196,68 @@ Regval8 CPU::subIndirect(){
     Regval8 prev = regs_8[A];
     Regval8 val = mem.read(getRegPair(H,L));
     regs_8[A] -= val;
-    if(fullCarry(prev, val, SUB, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(prev, val, SUB, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    deferFlags(FLAGS_SUB, prev, val, 0, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::subImm(Regval8 imm){
     Regval8 prev = regs_8[A];
-    regs_8[A] -= imm;
-    if(fullCarry(prev, imm, SUB, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(prev, imm, SUB, false)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    Regval8 val = imm;
+    regs_8[A] -= val;
+    deferFlags(FLAGS_SUB, prev, val, 0, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::subRegCarry(RegIndex_8 reg){
     Regval8 prev = regs_8[A];
-    regs_8[A] -= regs_8[reg];
-    regs_8[A] -= regs_8[F] & CARRY_FLAG ? 1 : 0;
-    if(halfCarry(prev, regs_8[reg], SUB, true)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(fullCarry(prev, regs_8[reg], SUB, true)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    Regval8 carry = getFlag(CARRY_FLAG) ? 1 : 0;
+    regs_8[A] -= regs_8[reg] + carry;
+    deferFlags(FLAGS_SUB, prev, regs_8[reg], carry, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::subIndirectCarry(){
     Regval8 prev = regs_8[A];
     Regval8 val = mem.read(getRegPair(H,L));
-    regs_8[A] -= val;
-    regs_8[A] -= regs_8[F] & CARRY_FLAG ? 1 : 0;
-    if(halfCarry(prev, val, SUB, true)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(fullCarry(prev, val, SUB, true)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    Regval8 carry = getFlag(CARRY_FLAG) ? 1 : 0;
+    regs_8[A] -= val + carry;
+    deferFlags(FLAGS_SUB, prev, val, carry, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::subImmCarry(Regval8 imm){
     Regval8 prev = regs_8[A];
-    regs_8[A] -= imm;
-    regs_8[A] -= regs_8[F] & CARRY_FLAG ? 1 : 0;
-    if(halfCarry(prev, imm, SUB, true)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(fullCarry(prev, imm, SUB, true)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    Regval8 val = imm;
+    Regval8 carry = getFlag(CARRY_FLAG) ? 1 : 0;
+    regs_8[A] -= val + carry;
+    deferFlags(FLAGS_SUB, prev, val, carry, regs_8[A], ALL_FLAGS);
     return regs_8[A];
 }
 
 Regval8 CPU::compareReg(RegIndex_8 reg){
-    Regval8 prev = regs_8[A];
-    Regval8 res = regs_8[A] - regs_8[reg];
-    if(fullCarry(prev, regs_8[reg], SUB, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(prev, regs_8[reg], SUB, false)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(res == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
-    return regs_8[F];
+    Regval8 val = regs_8[reg];
+    Regval8 res = regs_8[A] - val;
+    deferFlags(FLAGS_SUB, regs_8[A], val, 0, res, ALL_FLAGS);
+    return res;
 }
 
 Regval8 CPU::compareIndirect(){
-    Regval8 prev = regs_8[A];
     Regval8 val = mem.read(getRegPair(H,L));
     Regval8 res = regs_8[A] - val;
-    if(fullCarry(prev, val, SUB, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(prev, val, SUB, false)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(res == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
-    return regs_8[F];
+    deferFlags(FLAGS_SUB, regs_8[A], val, 0, res, ALL_FLAGS);
+    return res;
 }
 
 Regval8 CPU::compareImm(Regval8 imm){
-    Regval8 prev = regs_8[A];
-    Regval8 res = regs_8[A] - imm;
-    if(fullCarry(prev, imm, SUB, false)) 
-        regs_8[F] |= CARRY_FLAG;
-    else 
-        regs_8[F] &= ~CARRY_FLAG;
-    if(halfCarry(prev, imm, SUB, false)) 
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(res == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
-    return regs_8[F];
+    Regval8 val = imm;
+    Regval8 res = regs_8[A] - val;
+    deferFlags(FLAGS_SUB, regs_8[A], val, 0, res, ALL_FLAGS);
+    return res;
 }
 
 Regval8 CPU::incReg(RegIndex_8 reg){
-    Regval8 prev = regs_8[reg];
-    regs_8[reg] += 1;
-    if(halfCarry(prev, 1, ADD, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(regs_8[reg] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    Regval8 prev = regs_8[reg]++;
+    deferFlags(FLAGS_ADD, prev, 1, 0, regs_8[reg], ZERO_FLAG | SUBTRACT_FLAG | HALF_CARRY_FLAG);
     return regs_8[reg];
 }
 
@@ -423,30 +265,13 @@ Regval8 CPU::incIndirect(){
     Regval8 val = mem.read(getRegPair(H,L));
     Regval8 prev = val++;
     mem.write(getRegPair(H,L), val);
-    if(halfCarry(prev, 1, ADD, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    deferFlags(FLAGS_ADD, prev, 1, 0, val, ZERO_FLAG | SUBTRACT_FLAG | HALF_CARRY_FLAG);
     return val;
 }
 
 Regval8 CPU::decReg(RegIndex_8 reg){
-    Regval8 prev = regs_8[reg];
-    regs_8[reg] -= 1;
-    if(halfCarry(prev, 1, SUB, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(regs_8[reg] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    Regval8 prev = regs_8[reg]--;
+    deferFlags(FLAGS_SUB, prev, 1, 0, regs_8[reg], ZERO_FLAG | SUBTRACT_FLAG | HALF_CARRY_FLAG);
     return regs_8[reg];
 }
 
@@ -454,144 +279,76 @@ Regval8 CPU::decIndirect(){
     Regval8 val = mem.read(getRegPair(H,L));
     Regval8 prev = val--;
     mem.write(getRegPair(H,L), val);
-    if(halfCarry(prev, 1, SUB, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] |= SUBTRACT_FLAG;
+    deferFlags(FLAGS_SUB, prev, 1, 0, val, ZERO_FLAG | SUBTRACT_FLAG | HALF_CARRY_FLAG);
     return val;
 }
 
 Regval8 CPU::andReg(RegIndex_8 reg){
     regs_8[A] &= regs_8[reg];
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] |= HALF_CARRY_FLAG;
+    setFlags(ALL_FLAGS, (regs_8[A] ? 0 : ZERO_FLAG) | HALF_CARRY_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::andIndirect(){
-    Regval8 val = mem.read(getRegPair(H,L));
-    regs_8[A] &= val;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] |= HALF_CARRY_FLAG;
+    regs_8[A] &= mem.read(getRegPair(H,L));
+    setFlags(ALL_FLAGS, (regs_8[A] ? 0 : ZERO_FLAG) | HALF_CARRY_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::andImm(Regval8 imm){
-    regs_8[A] &= imm; 
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] |= HALF_CARRY_FLAG;
+    regs_8[A] &= imm;
+    setFlags(ALL_FLAGS, (regs_8[A] ? 0 : ZERO_FLAG) | HALF_CARRY_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::orReg(RegIndex_8 reg){
     regs_8[A] |= regs_8[reg];
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+    setFlags(ALL_FLAGS, regs_8[A] ? 0 : ZERO_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::orIndirect(){
-    Regval8 val = mem.read(getRegPair(H,L));
-    regs_8[A] |= val;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+    regs_8[A] |= mem.read(getRegPair(H,L));
+    setFlags(ALL_FLAGS, regs_8[A] ? 0 : ZERO_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::orImm(Regval8 imm){
-    regs_8[A] |= imm; 
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+    regs_8[A] |= imm;
+    setFlags(ALL_FLAGS, regs_8[A] ? 0 : ZERO_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::xorReg(RegIndex_8 reg){
     regs_8[A] ^= regs_8[reg];
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+    setFlags(ALL_FLAGS, regs_8[A] ? 0 : ZERO_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::xorIndirect(){
-    Regval8 val = mem.read(getRegPair(H,L));
-    regs_8[A] ^= val;
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+    regs_8[A] ^= mem.read(getRegPair(H,L));
+    setFlags(ALL_FLAGS, regs_8[A] ? 0 : ZERO_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::xorImm(Regval8 imm){
-    regs_8[A] ^= imm; 
-    if(regs_8[A] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+    regs_8[A] ^= imm;
+    setFlags(ALL_FLAGS, regs_8[A] ? 0 : ZERO_FLAG);
     return regs_8[A];
 }
 
 Regval8 CPU::compCarryFlag(){
-    regs_8[F] ^= CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[F];
+    setFlags(SUBTRACT_FLAG | HALF_CARRY_FLAG | CARRY_FLAG, getFlag(CARRY_FLAG) ? 0 : CARRY_FLAG);
+    return getReg(F);
 }
 
 Regval8 CPU::setCarryFlag(){
-    regs_8[F] |= CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[F];
+    setFlags(SUBTRACT_FLAG | HALF_CARRY_FLAG | CARRY_FLAG, CARRY_FLAG);
+    return getReg(F);
 }
 
 Regval8 CPU::decimalAdjustAcc(){
+    resolveFlags();
     if(!(regs_8[F] & SUBTRACT_FLAG)){
         if((regs_8[F] & CARRY_FLAG) || (regs_8[A] > 0x99)){
             regs_8[A] += 0x60;
@@ -619,8 +376,7 @@ Regval8 CPU::decimalAdjustAcc(){
 
 Regval8 CPU::compAcc(){
     regs_8[A] ^= 0xFF;
-    regs_8[F] |= SUBTRACT_FLAG;
-    regs_8[F] |= HALF_CARRY_FLAG;
+    setFlags(SUBTRACT_FLAG | HALF_CARRY_FLAG, SUBTRACT_FLAG | HALF_CARRY_FLAG);
     return regs_8[A];
 }
 
@@ -744,6 +500,9 @@ Regval16 CPU::loadSPHL(){
 }
 
 Regval16 CPU::push(RegIndex_8 msr, RegIndex_8 lsr){
+    if(lsr == F){
+        resolveFlags();
+    }
     mem.write(--regs_16[SP], regs_8[msr]);
     mem.write(--regs_16[SP], regs_8[lsr]);
     return regs_16[SP];
@@ -757,6 +516,7 @@ Regval16 CPU::pop(RegIndex_8 msr, RegIndex_8 lsr){
     regs_8[msr] = mem.read(regs_16[SP]++);
     if(lsr == F){ //temp fix
         regs_8[F] &= 0xF0;
+        lazy.mask = 0;
     }
     return regs_16[SP];
 }
@@ -780,25 +540,25 @@ bool CPU::jumpRelCond(int8_t imm, Condition cond){
     imm++; //relative to the NEXT instruction.
     switch(cond){
         case ZERO:
-            if(regs_8[F] & ZERO_FLAG){
+            if(getFlag(ZERO_FLAG)){
                 regs_16[PC] += imm;
                 return true;
             }
             break;
         case NOT_ZERO:
-            if(!(regs_8[F] & ZERO_FLAG)){
+            if(!getFlag(ZERO_FLAG)){
                 regs_16[PC] += imm;
                 return true;
             }
             break;
         case CARRY:
-            if(regs_8[F] & CARRY_FLAG){
+            if(getFlag(CARRY_FLAG)){
                 regs_16[PC] += imm;
                 return true;
             }
             break;
         case NO_CARRY:
-            if(!(regs_8[F] & CARRY_FLAG)){
+            if(!getFlag(CARRY_FLAG)){
                 regs_16[PC] += imm;
                 return true;
             }
@@ -810,25 +570,25 @@ bool CPU::jumpRelCond(int8_t imm, Condition cond){
 bool CPU::jumpCond(Regval16 addr, Condition cond){
     switch(cond){
         case ZERO:
-            if(regs_8[F] & ZERO_FLAG){
+            if(getFlag(ZERO_FLAG)){
                 regs_16[PC] = addr;
                 return true;
             }
             break;
         case NOT_ZERO:
-            if(!(regs_8[F] & ZERO_FLAG)){
+            if(!getFlag(ZERO_FLAG)){
                 regs_16[PC] = addr;
                 return true;
             }
             break;
         case CARRY:
-            if(regs_8[F] & CARRY_FLAG){
+            if(getFlag(CARRY_FLAG)){
                 regs_16[PC] = addr;
                 return true;
             }
             break;
         case NO_CARRY:
-            if(!(regs_8[F] & CARRY_FLAG)){
+            if(!getFlag(CARRY_FLAG)){
                 regs_16[PC] = addr;
                 return true;
             }
@@ -856,25 +616,25 @@ Regval16 CPU::callInt(Regval16 addr){
 bool CPU::callCond(Regval16 addr, Condition cond){
     switch(cond){
         case ZERO:
-            if(regs_8[F] & ZERO_FLAG){
+            if(getFlag(ZERO_FLAG)){
                 call(addr);
                 return true;
             }
             break;
         case NOT_ZERO:
-            if(!(regs_8[F] & ZERO_FLAG)){
+            if(!getFlag(ZERO_FLAG)){
                 call(addr);
                 return true;
             }
             break;
         case CARRY:
-            if(regs_8[F] & CARRY_FLAG){
+            if(getFlag(CARRY_FLAG)){
                 call(addr);
                 return true;
             }
             break;
         case NO_CARRY:
-            if(!(regs_8[F] & CARRY_FLAG)){
+            if(!getFlag(CARRY_FLAG)){
                 call(addr);
                 return true;
             }
@@ -894,25 +654,25 @@ Regval16 CPU::ret(){
 bool CPU::retCond(Condition cond){
     switch(cond){
         case ZERO:
-            if(regs_8[F] & ZERO_FLAG){
+            if(getFlag(ZERO_FLAG)){
                 ret();
                 return true;
             }
             break;
         case NOT_ZERO:
-            if(!(regs_8[F] & ZERO_FLAG)){
+            if(!getFlag(ZERO_FLAG)){
                 ret();
                 return true;
             }
             break;
         case CARRY:
-            if(regs_8[F] & CARRY_FLAG){
+            if(getFlag(CARRY_FLAG)){
                 ret();
                 return true;
             }
             break;
         case NO_CARRY:
-            if(!(regs_8[F] & CARRY_FLAG)){
+            if(!getFlag(CARRY_FLAG)){
                 ret();
                 return true;
             }
@@ -936,312 +696,157 @@ Regval16 CPU::rst(Regval8 addr){
 }
 
 Regval8 CPU::rlc(RegIndex_8 reg, bool cb){
-    regs_8[reg] = (regs_8[reg] << 1) | (regs_8[reg] >> 7);
-    if(regs_8[reg] & 0x01)
-        regs_8[F] |= CARRY_FLAG;
-    else
-        regs_8[F] &= ~CARRY_FLAG;
-    if(cb){
-        if(regs_8[reg] == 0)
-            regs_8[F] |= ZERO_FLAG;
-        else
-            regs_8[F] &= ~ZERO_FLAG;
-    }
-    else{
-        regs_8[F] &= ~ZERO_FLAG;
-    }
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[reg]; 
+    regs_8[reg] = regs_8[reg] << 1 | regs_8[reg] >> 7;
+    Regval8 flags = regs_8[reg] & 0x01 ? CARRY_FLAG : 0;
+    if(cb && regs_8[reg] == 0)
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return regs_8[reg];
 }
 
 Regval8 CPU::rlcInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
     val = val << 1 | val >> 7;
-    if(val & 0x01)
-        regs_8[F] |= CARRY_FLAG;
-    else
-        regs_8[F] &= ~CARRY_FLAG;
+    Regval8 flags = val & 0x01 ? CARRY_FLAG : 0;
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
     return mem.write(addr, val);
 }
 
 Regval8 CPU::rrc(RegIndex_8 reg, bool cb){
-    regs_8[reg] = (regs_8[reg] >> 1) | (regs_8[reg] << 7);
-    if(regs_8[reg] & 0x80)
-        regs_8[F] |= CARRY_FLAG;
-    else
-        regs_8[F] &= ~CARRY_FLAG;
-    if(cb){
-        if(regs_8[reg] == 0)
-            regs_8[F] |= ZERO_FLAG;
-        else
-            regs_8[F] &= ~ZERO_FLAG;
-    }
-    else{
-        regs_8[F] &= ~ZERO_FLAG;
-    }
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[reg]; 
+    regs_8[reg] = regs_8[reg] >> 1 | regs_8[reg] << 7;
+    Regval8 flags = regs_8[reg] & 0x80 ? CARRY_FLAG : 0;
+    if(cb && regs_8[reg] == 0)
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return regs_8[reg];
 }
 
 Regval8 CPU::rrcInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
     val = val >> 1 | val << 7;
-    if(val & 0x80)
-        regs_8[F] |= CARRY_FLAG;
-    else
-        regs_8[F] &= ~CARRY_FLAG;
+    Regval8 flags = val & 0x80 ? CARRY_FLAG : 0;
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
     return mem.write(addr, val);
 }
 
 Regval8 CPU::rr(RegIndex_8 reg, bool cb){
-    if(regs_8[F] & CARRY_FLAG){
-        if(!(regs_8[reg] & 0x01)){
-            regs_8[F] &= ~CARRY_FLAG;
-        }
-        regs_8[reg] = regs_8[reg] >> 1 | 0x80;
-    }
-    else{
-        if(regs_8[reg] & 0x01){
-            regs_8[F] |= CARRY_FLAG;
-        }
-        regs_8[reg] = regs_8[reg] >> 1;
-    }
-    if(cb){
-        if(regs_8[reg] == 0)
-            regs_8[F] |= ZERO_FLAG;
-        else
-            regs_8[F] &= ~ZERO_FLAG;
-    }
-    else{
-        regs_8[F] &= ~ZERO_FLAG;
-    }
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[reg]; 
+    Regval8 carry = getFlag(CARRY_FLAG) ? 0x80 : 0;
+    Regval8 flags = regs_8[reg] & 0x01 ? CARRY_FLAG : 0;
+    regs_8[reg] = regs_8[reg] >> 1 | carry;
+    if(cb && regs_8[reg] == 0)
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return regs_8[reg];
 }
 
 Regval8 CPU::rrInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
-    if(regs_8[F] & CARRY_FLAG){
-        if(!(val & 0x01)){
-            regs_8[F] &= ~CARRY_FLAG;
-        }
-        val = val >> 1 | 0x80;
-    }
-    else{
-        if(val & 0x01){
-            regs_8[F] |= CARRY_FLAG;
-        }
-        val = val >> 1;
-    }
+    Regval8 carry = getFlag(CARRY_FLAG) ? 0x80 : 0;
+    Regval8 flags = val & 0x01 ? CARRY_FLAG : 0;
+    val = val >> 1 | carry;
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
     return mem.write(addr, val);
 }
 
 Regval8 CPU::rl(RegIndex_8 reg, bool cb){
-    if(regs_8[F] & CARRY_FLAG){
-        if(!(regs_8[reg] & 0x80)){
-            regs_8[F] &= ~CARRY_FLAG;
-        }
-        regs_8[reg] = regs_8[reg] << 1 | 0x01;
-    }
-    else{
-        if(regs_8[reg] & 0x80){
-            regs_8[F] |= CARRY_FLAG;
-        }
-        regs_8[reg] = regs_8[reg] << 1;
-    }
-    if(cb){
-        if(regs_8[reg] == 0)
-            regs_8[F] |= ZERO_FLAG;
-        else
-            regs_8[F] &= ~ZERO_FLAG;
-    }
-    else{
-        regs_8[F] &= ~ZERO_FLAG;
-    }
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[reg]; 
+    Regval8 carry = getFlag(CARRY_FLAG) ? 0x01 : 0;
+    Regval8 flags = regs_8[reg] & 0x80 ? CARRY_FLAG : 0;
+    regs_8[reg] = regs_8[reg] << 1 | carry;
+    if(cb && regs_8[reg] == 0)
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return regs_8[reg];
 }
 
 Regval8 CPU::rlInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
-    if(regs_8[F] & CARRY_FLAG){
-        if(!(val & 0x80)){
-            regs_8[F] &= ~CARRY_FLAG;
-        }
-        val = val << 1 | 0x01;
-    }
-    else{
-        if(val & 0x80){
-            regs_8[F] |= CARRY_FLAG;
-        }
-        val = val << 1;
-    }
+    Regval8 carry = getFlag(CARRY_FLAG) ? 0x01 : 0;
+    Regval8 flags = val & 0x80 ? CARRY_FLAG : 0;
+    val = val << 1 | carry;
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
     return mem.write(addr, val);
 }
 
 Regval8 CPU::sla(RegIndex_8 reg){
-    if(regs_8[reg] & 0x80){
-        regs_8[F] |= CARRY_FLAG;
-    }
-    else{
-        regs_8[F] &= ~CARRY_FLAG;
-    }
+    Regval8 flags = regs_8[reg] & 0x80 ? CARRY_FLAG : 0;
     regs_8[reg] <<= 1;
     if(regs_8[reg] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[reg]; 
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return regs_8[reg];
 }
 
 Regval8 CPU::slaInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
-    if(val & 0x80){
-        regs_8[F] |= CARRY_FLAG;
-    }
-    else{
-        regs_8[F] &= ~CARRY_FLAG;
-    }
+    Regval8 flags = val & 0x80 ? CARRY_FLAG : 0;
     val <<= 1;
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return mem.write(addr, val); 
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return mem.write(addr, val);
 }
 
 Regval8 CPU::sra(RegIndex_8 reg){
-    if(regs_8[reg] & 0x01){
-        regs_8[F] |= CARRY_FLAG;
-    }
-    else{
-        regs_8[F] &= ~CARRY_FLAG;
-    }
-    //check MSB to shift properly
-    if(regs_8[reg] & 0x80){
-        regs_8[reg] >>= 1;
-        regs_8[reg] |= 0x80;
-    }
-    else{
-        regs_8[reg] >>= 1;
-    }
+    Regval8 flags = regs_8[reg] & 0x01 ? CARRY_FLAG : 0;
+    //the sign bit stays put
+    regs_8[reg] = regs_8[reg] >> 1 | (regs_8[reg] & 0x80);
     if(regs_8[reg] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[reg]; 
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return regs_8[reg];
 }
 
 Regval8 CPU::sraInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
-    if(val & 0x01){
-        regs_8[F] |= CARRY_FLAG;
-    }
-    else{
-        regs_8[F] &= ~CARRY_FLAG;
-    }
-    //check MSB to shift properly
-    if(val & 0x80){
-        val >>= 1;
-        val |= 0x80;
-    }
-    else{
-        val >>= 1;
-    }
+    Regval8 flags = val & 0x01 ? CARRY_FLAG : 0;
+    //the sign bit stays put
+    val = val >> 1 | (val & 0x80);
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return mem.write(addr, val); 
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return mem.write(addr, val);
 }
 
 Regval8 CPU::srl(RegIndex_8 reg){
-    if(regs_8[reg] & 0x01){
-        regs_8[F] |= CARRY_FLAG;
-    }
-    else{
-        regs_8[F] &= ~CARRY_FLAG;
-    }
+    Regval8 flags = regs_8[reg] & 0x01 ? CARRY_FLAG : 0;
     regs_8[reg] >>= 1;
     if(regs_8[reg] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return regs_8[reg]; 
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return regs_8[reg];
 }
 
 Regval8 CPU::srlInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
-    if(val & 0x01){
-        regs_8[F] |= CARRY_FLAG;
-    }
-    else{
-        regs_8[F] &= ~CARRY_FLAG;
-    }
+    Regval8 flags = val & 0x01 ? CARRY_FLAG : 0;
     val >>= 1;
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    return mem.write(addr, val); 
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
+    return mem.write(addr, val);
 }
 
 Regval8 CPU::swap(RegIndex_8 reg){
     regs_8[reg] = regs_8[reg] >> 4 | regs_8[reg] << 4;
+    Regval8 flags = 0;
     if(regs_8[reg] == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
     return regs_8[reg];
 }
 
@@ -1249,39 +854,22 @@ Regval8 CPU::swapInd(){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
     val = val >> 4 | val << 4;
+    Regval8 flags = 0;
     if(val == 0)
-        regs_8[F] |= ZERO_FLAG;
-    else
-        regs_8[F] &= ~ZERO_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] &= ~HALF_CARRY_FLAG;
-    regs_8[F] &= ~CARRY_FLAG;
+        flags |= ZERO_FLAG;
+    setFlags(ALL_FLAGS, flags);
     return mem.write(addr, val);
 }
 
 Regval8 CPU::bit(RegIndex_8 reg, BitIndex index){
-    if(regs_8[reg] & index){
-        regs_8[F] &= ~ZERO_FLAG;
-    }
-    else{
-        regs_8[F] |= ZERO_FLAG;
-    }
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] |= HALF_CARRY_FLAG;
+    setFlags(ZERO_FLAG | SUBTRACT_FLAG | HALF_CARRY_FLAG, (regs_8[reg] & index ? 0 : ZERO_FLAG) | HALF_CARRY_FLAG);
     return regs_8[reg];
 }
 
 Regval8 CPU::bitInd(BitIndex index){
     Regval16 addr = getRegPair(H,L);
     Regval8 val = mem.read(addr);
-    if(val & index){
-        regs_8[F] &= ~ZERO_FLAG;
-    }
-    else{
-        regs_8[F] |= ZERO_FLAG;
-    }
-    regs_8[F] &= ~SUBTRACT_FLAG;
-    regs_8[F] |= HALF_CARRY_FLAG;
+    setFlags(ZERO_FLAG | SUBTRACT_FLAG | HALF_CARRY_FLAG, (val & index ? 0 : ZERO_FLAG) | HALF_CARRY_FLAG);
     return val;
 }
 
@@ -1372,25 +960,21 @@ Regval16 CPU::decSP(){
 }
 
 Regval16 CPU::addHLRegPair(RegIndex_8 msr, RegIndex_8 lsr){
-    regs_8[F] &= ~CARRY_FLAG;
-    addRegRegCarry(L, lsr);
-    addRegRegCarry(H, msr);
+    Regval16 prev = getRegPair(H,L);
+    Regval16 val = getRegPair(msr, lsr);
+    setRegPair(H, L, prev + val);
+    deferFlags(FLAGS_ADD_16, prev, val, 0, 0, SUBTRACT_FLAG | HALF_CARRY_FLAG | CARRY_FLAG);
     return getRegPair(H,L);
 }
 
 Regval16 CPU::addHLSP(){
-    Regval8 prevH = regs_8[H];
-    Regval16 val = getRegPair(H,L) + regs_16[SP];
-    if(val < getRegPair(H,L))
-        regs_8[F] |= CARRY_FLAG;
-    else
-        regs_8[F] &= ~CARRY_FLAG;
+    Regval16 prev = getRegPair(H,L);
+    Regval16 val = prev + regs_16[SP];
+    Regval8 flags = val < prev ? CARRY_FLAG : 0;
+    if(((prev >> 8) & 0x0F) + ((regs_16[SP] >> 8) & 0x0F) > 0x0F)
+        flags |= HALF_CARRY_FLAG;
     setRegPair(H,L,val);
-    if(halfCarry(prevH,regs_16[SP] >> 8, ADD, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
-    regs_8[F] &= ~SUBTRACT_FLAG;
+    setFlags(SUBTRACT_FLAG | HALF_CARRY_FLAG | CARRY_FLAG, flags);
     return val;
 }
 
@@ -1404,10 +988,7 @@ Regval16 CPU::addSPImm(int8_t imm){
     Regval8 prevLsb = regs_16[SP] & 0x00FF;
     regs_16[SP] += imm;
     Regval8 currLsb = regs_16[SP] & 0x00FF;
-    if(halfCarry(prevLsb, currLsb, ADD, false))
-        regs_8[F] |= HALF_CARRY_FLAG;
-    else
-        regs_8[F] &= ~HALF_CARRY_FLAG;
+    setFlags(HALF_CARRY_FLAG, (prevLsb & 0x0F) + (currLsb & 0x0F) > 0x0F ? HALF_CARRY_FLAG : 0);
     return regs_16[SP];
 }
 
@@ -1421,6 +1002,7 @@ Regval16 CPU::incPC(){
 }
 
 void CPU::printStatus(){
+    resolveFlags();
     printf("----REGS----\n");
     printf("ACC:   0x%02x\n", regs_8[A]);
     printf("B:     0x%02x\n", regs_8[B]);
@@ -1465,6 +1047,9 @@ void CPU::printStatus(){
 }    
 
 Regval8 CPU::getReg(RegIndex_8 reg){
+    if(reg == F){
+        resolveFlags();
+    }
     return regs_8[reg];
 }
 
@@ -0,0 +1,1169 @@
+#include "gameboy.h"
+#include "instructions.h"
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/*
+Every opcode is dispatched through a 256 entry table of member function
+pointers instead of a switch. Handlers are grouped by timing shape and
+templated on the CPU operation and its operands, so each table entry
+still runs the exact M-cycle sequence the switch used to.
+*/
+
+const std::array<Gameboy::OpHandler, 256> Gameboy::opTable = Gameboy::buildOpTable();
+const std::array<Gameboy::OpHandler, 256> Gameboy::cbTable = Gameboy::buildCbTable();
+
+/*
+Shared helper for every instruction with a 16-bit operand,
+the operand bytes are expected in msb/lsb.
+*/
+void Gameboy::fetchImm16(){
+    imm_16 = 0x0000;
+    imm_16 |= msb;
+    imm_16 = imm_16 << 8;
+    imm_16 |= lsb;
+}
+
+/*
+Reads the instruction byte at PC, served from the decoded block
+when the instruction came out of the block cache.
+*/
+Regval8 Gameboy::fetchByte(){
+    if(decodedOp){
+        return decodedOp->bytes[cpu.getPC() - decodedOp->pc];
+    }
+    return mem.read(cpu.getPC());
+}
+
+void Gameboy::opNop(){
+    cpu.incPC();
+}
+
+//HALT stays on its own opcode, runFSM() moves past it once an interrupt is pending
+void Gameboy::opHalt(){
+    if(!IME && interrupts.pending()){
+        haltBug = true;
+    }
+}
+
+void Gameboy::opStop(){
+}
+
+void Gameboy::opDi(){
+    IME = false;
+    imeDelay = false;
+    cpu.incPC();
+}
+
+void Gameboy::opEi(){
+    imeDelay = true;
+    cpu.incPC();
+}
+
+void Gameboy::opJumpHL(){
+    cpu.jumpHL();
+}
+
+void Gameboy::opInvalid(){
+    std::cout << "last opcode: 0x" << std::hex << (int)opcode << std::endl;
+    throw runtime_error("[ERROR] Opcode could not be resolved.\n");
+}
+
+template<auto op>
+void Gameboy::opImplied(){
+    (cpu.*op)();
+    cpu.incPC();
+}
+
+template<auto op, RegIndex_8 reg>
+void Gameboy::opReg(){
+    (cpu.*op)(reg);
+    cpu.incPC();
+}
+
+template<RegIndex_8 dst, RegIndex_8 src>
+void Gameboy::opLoadRegReg(){
+    cpu.loadRegReg(dst, src);
+    cpu.incPC();
+}
+
+template<auto op>
+void Gameboy::opRotateA(){
+    (cpu.*op)(A, false);
+    cpu.incPC();
+}
+
+template<RegIndex_8 msr, RegIndex_8 lsr>
+void Gameboy::opAddHLRegPair(){
+    cpu.addHLRegPair(msr, lsr);
+    cpu.incPC();
+}
+
+template<auto op>
+void Gameboy::opIndirect(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            (cpu.*op)();
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<auto op, RegIndex_8 reg>
+void Gameboy::opIndirectReg(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            (cpu.*op)(reg);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<auto op>
+void Gameboy::opImm(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            cpu.incPC();
+            break;
+        case EXECUTE_1:
+            imm_8 = fetchByte();
+            (cpu.*op)(imm_8);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+//Immediate is read one M-cycle ahead of the operation
+template<auto op>
+void Gameboy::opImmDelayed(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            imm_8 = fetchByte();
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            (cpu.*op)(imm_8);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<auto op>
+void Gameboy::opOffset(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            cpu.incPC();
+            break;
+        case EXECUTE_1:
+            imm_8 = fetchByte();
+            (cpu.*op)((int8_t)imm_8);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<auto op>
+void Gameboy::opOffsetDelayed(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            imm_8 = fetchByte();
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            (cpu.*op)((int8_t)imm_8);
+            cpu.incPC();
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+template<RegIndex_8 reg>
+void Gameboy::opLoadRegImm(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            cpu.incPC();
+            break;
+        case EXECUTE_1:
+            imm_8 = fetchByte();
+            cpu.loadRegImm(reg, imm_8);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<RegIndex_8 msr, RegIndex_8 lsr>
+void Gameboy::opLoadRegPairImm(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = EXECUTE_1;
+            cpu.incPC();
+            break;
+        case EXECUTE_1:
+            msb = fetchByte();
+            fetchImm16();
+            cpu.loadRegPairImm(msr, lsr, imm_16);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opLoadSPImm(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = EXECUTE_1;
+            cpu.incPC();
+            break;
+        case EXECUTE_1:
+            msb = fetchByte();
+            fetchImm16();
+            cpu.loadSPImm(imm_16);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<auto op>
+void Gameboy::opDirect(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = FETCH_2;
+            cpu.incPC();
+            break;
+        case FETCH_2:
+            msb = fetchByte();
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            fetchImm16();
+            (cpu.*op)(imm_16);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opLoadDirectSP(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = FETCH_2;
+            cpu.incPC();
+            break;
+        case FETCH_2:
+            msb = fetchByte();
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            state = EXECUTE_2;
+            break;
+        case EXECUTE_2:
+            fetchImm16();
+            cpu.loadDirectSP(imm_16);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<auto op, RegIndex_8 msr, RegIndex_8 lsr>
+void Gameboy::opStack(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            state = EXECUTE_2;
+            break;
+        case EXECUTE_2:
+            state = EXECUTE_3;
+            break;
+        case EXECUTE_3:
+            (cpu.*op)(msr, lsr);
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opJump(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = FETCH_2;
+            cpu.incPC();
+            break;
+        case FETCH_2:
+            msb = fetchByte();
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            fetchImm16();
+            cpu.jump(imm_16);
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+template<Condition cond>
+void Gameboy::opJumpCond(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = FETCH_2;
+            cpu.incPC();
+            break;
+        case FETCH_2:
+            msb = fetchByte();
+            fetchImm16();
+            if(cpu.jumpCond(imm_16, cond)){
+                state = EXECUTE_1;
+            }
+            else{
+                state = FETCH_OP;
+                cpu.incPC();
+            }
+            break;
+        case EXECUTE_1:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opJumpRel(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            imm_8 = fetchByte();
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            cpu.jumpRel((int8_t)imm_8);
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+template<Condition cond>
+void Gameboy::opJumpRelCond(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            cpu.incPC();
+            break;
+        case EXECUTE_1:
+            imm_8 = fetchByte();
+            if(cpu.jumpRelCond((int8_t)imm_8, cond)){
+                state = EXECUTE_2;
+            }
+            else{
+                state = FETCH_OP;
+                cpu.incPC();
+            }
+            break;
+        case EXECUTE_2:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opCall(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = FETCH_2;
+            cpu.incPC();
+            break;
+        case FETCH_2:
+            msb = fetchByte();
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            fetchImm16();
+            state = EXECUTE_2;
+            cpu.call(imm_16);
+            break;
+        case EXECUTE_2:
+            state = EXECUTE_3;
+            break;
+        case EXECUTE_3:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+template<Condition cond>
+void Gameboy::opCallCond(){
+    switch(state){
+        case FETCH_OP:
+            state = FETCH_1;
+            cpu.incPC();
+            break;
+        case FETCH_1:
+            lsb = fetchByte();
+            state = FETCH_2;
+            cpu.incPC();
+            break;
+        case FETCH_2:
+            msb = fetchByte();
+            fetchImm16();
+            if(cpu.callCond(imm_16, cond)){
+                state = EXECUTE_1;
+            }
+            else{
+                state = FETCH_OP;
+                cpu.incPC();
+            }
+            break;
+        case EXECUTE_1:
+            state = EXECUTE_2;
+            break;
+        case EXECUTE_2:
+            state = EXECUTE_3;
+            break;
+        case EXECUTE_3:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opRet(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            state = EXECUTE_2;
+            cpu.ret();
+            break;
+        case EXECUTE_2:
+            state = EXECUTE_3;
+            break;
+        case EXECUTE_3:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opReti(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            state = EXECUTE_2;
+            cpu.ret();
+            IME = true;
+            break;
+        case EXECUTE_2:
+            state = EXECUTE_3;
+            break;
+        case EXECUTE_3:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+template<Condition cond>
+void Gameboy::opRetCond(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            if(cpu.retCond(cond)){
+                state = EXECUTE_2;
+            }
+            else{
+                state = FETCH_OP;
+                cpu.incPC();
+            }
+            break;
+        case EXECUTE_2:
+            state = EXECUTE_3;
+            break;
+        case EXECUTE_3:
+            state = EXECUTE_4;
+            break;
+        case EXECUTE_4:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+template<Regval8 addr>
+void Gameboy::opRst(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            break;
+        case EXECUTE_1:
+            state = EXECUTE_2;
+            cpu.rst(addr);
+            break;
+        case EXECUTE_2:
+            state = EXECUTE_3;
+            break;
+        case EXECUTE_3:
+            state = FETCH_OP;
+            break;
+        default:
+            break;
+    }
+}
+
+void Gameboy::opCB(){
+    switch(state){
+        case FETCH_OP:
+            state = EXECUTE_1;
+            cpu.incPC();
+            break;
+        case EXECUTE_1:
+            cb_op = fetchByte();
+            executeCBOP();
+            state = FETCH_OP;
+            cpu.incPC();
+            break;
+        default:
+            break;
+    }
+}
+
+template<auto op, RegIndex_8 reg>
+void Gameboy::cbRotate(){
+    (cpu.*op)(reg, true);
+}
+
+template<auto op, RegIndex_8 reg>
+void Gameboy::cbShift(){
+    (cpu.*op)(reg);
+}
+
+template<auto op>
+void Gameboy::cbIndirect(){
+    (cpu.*op)();
+}
+
+template<auto op, RegIndex_8 reg, BitIndex index>
+void Gameboy::cbBit(){
+    (cpu.*op)(reg, index);
+}
+
+template<auto op, BitIndex index>
+void Gameboy::cbBitIndirect(){
+    (cpu.*op)(index);
+}
+
+std::array<Gameboy::OpHandler, 256> Gameboy::buildOpTable(){
+    std::array<OpHandler, 256> table;
+    table.fill(&Gameboy::opInvalid);
+    table[NOP] = &Gameboy::opNop;
+    table[HALT] = &Gameboy::opHalt;
+    table[STOP] = &Gameboy::opStop;
+    table[DI] = &Gameboy::opDi;
+    table[EI] = &Gameboy::opEi;
+    table[LD_B_B] = &Gameboy::opLoadRegReg<B, B>;
+    table[LD_B_C] = &Gameboy::opLoadRegReg<B, C>;
+    table[LD_B_D] = &Gameboy::opLoadRegReg<B, D>;
+    table[LD_B_E] = &Gameboy::opLoadRegReg<B, E>;
+    table[LD_B_H] = &Gameboy::opLoadRegReg<B, H>;
+    table[LD_B_L] = &Gameboy::opLoadRegReg<B, L>;
+    table[LD_B_A] = &Gameboy::opLoadRegReg<B, A>;
+    table[LD_C_B] = &Gameboy::opLoadRegReg<C, B>;
+    table[LD_C_C] = &Gameboy::opLoadRegReg<C, C>;
+    table[LD_C_D] = &Gameboy::opLoadRegReg<C, D>;
+    table[LD_C_E] = &Gameboy::opLoadRegReg<C, E>;
+    table[LD_C_H] = &Gameboy::opLoadRegReg<C, H>;
+    table[LD_C_L] = &Gameboy::opLoadRegReg<C, L>;
+    table[LD_C_A] = &Gameboy::opLoadRegReg<C, A>;
+    table[LD_D_B] = &Gameboy::opLoadRegReg<D, B>;
+    table[LD_D_C] = &Gameboy::opLoadRegReg<D, C>;
+    table[LD_D_D] = &Gameboy::opLoadRegReg<D, D>;
+    table[LD_D_E] = &Gameboy::opLoadRegReg<D, E>;
+    table[LD_D_H] = &Gameboy::opLoadRegReg<D, H>;
+    table[LD_D_L] = &Gameboy::opLoadRegReg<D, L>;
+    table[LD_D_A] = &Gameboy::opLoadRegReg<D, A>;
+    table[LD_E_B] = &Gameboy::opLoadRegReg<E, B>;
+    table[LD_E_C] = &Gameboy::opLoadRegReg<E, C>;
+    table[LD_E_D] = &Gameboy::opLoadRegReg<E, D>;
+    table[LD_E_E] = &Gameboy::opLoadRegReg<E, E>;
+    table[LD_E_H] = &Gameboy::opLoadRegReg<E, H>;
+    table[LD_E_L] = &Gameboy::opLoadRegReg<E, L>;
+    table[LD_E_A] = &Gameboy::opLoadRegReg<E, A>;
+    table[LD_H_B] = &Gameboy::opLoadRegReg<H, B>;
+    table[LD_H_C] = &Gameboy::opLoadRegReg<H, C>;
+    table[LD_H_D] = &Gameboy::opLoadRegReg<H, D>;
+    table[LD_H_E] = &Gameboy::opLoadRegReg<H, E>;
+    table[LD_H_H] = &Gameboy::opLoadRegReg<H, H>;
+    table[LD_H_L] = &Gameboy::opLoadRegReg<H, L>;
+    table[LD_H_A] = &Gameboy::opLoadRegReg<H, A>;
+    table[LD_L_B] = &Gameboy::opLoadRegReg<L, B>;
+    table[LD_L_C] = &Gameboy::opLoadRegReg<L, C>;
+    table[LD_L_D] = &Gameboy::opLoadRegReg<L, D>;
+    table[LD_L_E] = &Gameboy::opLoadRegReg<L, E>;
+    table[LD_L_H] = &Gameboy::opLoadRegReg<L, H>;
+    table[LD_L_L] = &Gameboy::opLoadRegReg<L, L>;
+    table[LD_L_A] = &Gameboy::opLoadRegReg<L, A>;
+    table[LD_A_B] = &Gameboy::opLoadRegReg<A, B>;
+    table[LD_A_C] = &Gameboy::opLoadRegReg<A, C>;
+    table[LD_A_D] = &Gameboy::opLoadRegReg<A, D>;
+    table[LD_A_E] = &Gameboy::opLoadRegReg<A, E>;
+    table[LD_A_H] = &Gameboy::opLoadRegReg<A, H>;
+    table[LD_A_L] = &Gameboy::opLoadRegReg<A, L>;
+    table[LD_A_A] = &Gameboy::opLoadRegReg<A, A>;
+    table[LD_B_IMM] = &Gameboy::opLoadRegImm<B>;
+    table[LD_C_IMM] = &Gameboy::opLoadRegImm<C>;
+    table[LD_D_IMM] = &Gameboy::opLoadRegImm<D>;
+    table[LD_E_IMM] = &Gameboy::opLoadRegImm<E>;
+    table[LD_H_IMM] = &Gameboy::opLoadRegImm<H>;
+    table[LD_L_IMM] = &Gameboy::opLoadRegImm<L>;
+    table[LD_A_IMM] = &Gameboy::opLoadRegImm<A>;
+    table[LD_B_HL] = &Gameboy::opIndirectReg<&CPU::loadRegIndirect, B>;
+    table[LD_C_HL] = &Gameboy::opIndirectReg<&CPU::loadRegIndirect, C>;
+    table[LD_D_HL] = &Gameboy::opIndirectReg<&CPU::loadRegIndirect, D>;
+    table[LD_E_HL] = &Gameboy::opIndirectReg<&CPU::loadRegIndirect, E>;
+    table[LD_H_HL] = &Gameboy::opIndirectReg<&CPU::loadRegIndirect, H>;
+    table[LD_L_HL] = &Gameboy::opIndirectReg<&CPU::loadRegIndirect, L>;
+    table[LD_A_HL] = &Gameboy::opIndirectReg<&CPU::loadRegIndirect, A>;
+    table[LD_HL_B] = &Gameboy::opIndirectReg<&CPU::loadIndirectReg, B>;
+    table[LD_HL_C] = &Gameboy::opIndirectReg<&CPU::loadIndirectReg, C>;
+    table[LD_HL_D] = &Gameboy::opIndirectReg<&CPU::loadIndirectReg, D>;
+    table[LD_HL_E] = &Gameboy::opIndirectReg<&CPU::loadIndirectReg, E>;
+    table[LD_HL_H] = &Gameboy::opIndirectReg<&CPU::loadIndirectReg, H>;
+    table[LD_HL_L] = &Gameboy::opIndirectReg<&CPU::loadIndirectReg, L>;
+    table[LD_HL_A] = &Gameboy::opIndirectReg<&CPU::loadIndirectReg, A>;
+    table[LD_HL_IMM_IND] = &Gameboy::opImmDelayed<&CPU::loadIndirectImm>;
+    table[LD_A_BC] = &Gameboy::opIndirect<&CPU::loadABC>;
+    table[LD_A_DE] = &Gameboy::opIndirect<&CPU::loadADE>;
+    table[LD_BC_A] = &Gameboy::opIndirect<&CPU::loadBCA>;
+    table[LD_DE_A] = &Gameboy::opIndirect<&CPU::loadDEA>;
+    table[LD_A_ADDR] = &Gameboy::opDirect<&CPU::loadAImmDirect>;
+    table[LD_ADDR_A] = &Gameboy::opDirect<&CPU::loadImmADirect>;
+    table[LDH_A_C] = &Gameboy::opIndirect<&CPU::loadHighAC>;
+    table[LDH_C_A] = &Gameboy::opIndirect<&CPU::loadHighCA>;
+    table[LDH_A_IMM] = &Gameboy::opImmDelayed<&CPU::loadHighAImm>;
+    table[LDH_IMM_A] = &Gameboy::opImmDelayed<&CPU::loadHighImmA>;
+    table[LD_A_HL_DEC] = &Gameboy::opIndirect<&CPU::loadAIndirectDec>;
+    table[LD_HL_A_DEC] = &Gameboy::opIndirect<&CPU::loadIndirectADec>;
+    table[LD_A_HL_INC] = &Gameboy::opIndirect<&CPU::loadAIndirectInc>;
+    table[LD_HL_A_INC] = &Gameboy::opIndirect<&CPU::loadIndirectAInc>;
+    table[LD_BC_IMM] = &Gameboy::opLoadRegPairImm<B, C>;
+    table[LD_DE_IMM] = &Gameboy::opLoadRegPairImm<D, E>;
+    table[LD_HL_IMM] = &Gameboy::opLoadRegPairImm<H, L>;
+    table[LD_SP_IMM] = &Gameboy::opLoadSPImm;
+    table[LD_DIR_SP] = &Gameboy::opLoadDirectSP;
+    table[LD_SP_HL] = &Gameboy::opIndirect<&CPU::loadSPHL>;
+    table[PUSH_BC] = &Gameboy::opStack<&CPU::push, B, C>;
+    table[PUSH_DE] = &Gameboy::opStack<&CPU::push, D, E>;
+    table[PUSH_HL] = &Gameboy::opStack<&CPU::push, H, L>;
+    table[PUSH_AF] = &Gameboy::opStack<&CPU::push, A, F>;
+    table[POP_BC] = &Gameboy::opStack<&CPU::pop, B, C>;
+    table[POP_DE] = &Gameboy::opStack<&CPU::pop, D, E>;
+    table[POP_HL] = &Gameboy::opStack<&CPU::pop, H, L>;
+    table[POP_AF] = &Gameboy::opStack<&CPU::pop, A, F>;
+    table[ADD_IMM] = &Gameboy::opImm<&CPU::addImm>;
+    table[ADD_A] = &Gameboy::opReg<&CPU::addReg, A>;
+    table[ADD_B] = &Gameboy::opReg<&CPU::addReg, B>;
+    table[ADD_C] = &Gameboy::opReg<&CPU::addReg, C>;
+    table[ADD_D] = &Gameboy::opReg<&CPU::addReg, D>;
+    table[ADD_E] = &Gameboy::opReg<&CPU::addReg, E>;
+    table[ADD_H] = &Gameboy::opReg<&CPU::addReg, H>;
+    table[ADD_L] = &Gameboy::opReg<&CPU::addReg, L>;
+    table[ADD_IND] = &Gameboy::opIndirect<&CPU::addIndirect>;
+    table[ADC_A] = &Gameboy::opReg<&CPU::addRegCarry, A>;
+    table[ADC_B] = &Gameboy::opReg<&CPU::addRegCarry, B>;
+    table[ADC_C] = &Gameboy::opReg<&CPU::addRegCarry, C>;
+    table[ADC_D] = &Gameboy::opReg<&CPU::addRegCarry, D>;
+    table[ADC_E] = &Gameboy::opReg<&CPU::addRegCarry, E>;
+    table[ADC_H] = &Gameboy::opReg<&CPU::addRegCarry, H>;
+    table[ADC_L] = &Gameboy::opReg<&CPU::addRegCarry, L>;
+    table[ADC_IND] = &Gameboy::opIndirect<&CPU::addIndirectCarry>;
+    table[ADC_IMM] = &Gameboy::opImm<&CPU::addImmCarry>;
+    table[SUB_A] = &Gameboy::opReg<&CPU::subReg, A>;
+    table[SUB_B] = &Gameboy::opReg<&CPU::subReg, B>;
+    table[SUB_C] = &Gameboy::opReg<&CPU::subReg, C>;
+    table[SUB_D] = &Gameboy::opReg<&CPU::subReg, D>;
+    table[SUB_E] = &Gameboy::opReg<&CPU::subReg, E>;
+    table[SUB_H] = &Gameboy::opReg<&CPU::subReg, H>;
+    table[SUB_L] = &Gameboy::opReg<&CPU::subReg, L>;
+    table[SUB_IND] = &Gameboy::opIndirect<&CPU::subIndirect>;
+    table[SUB_IMM] = &Gameboy::opImm<&CPU::subImm>;
+    table[SBC_A] = &Gameboy::opReg<&CPU::subRegCarry, A>;
+    table[SBC_B] = &Gameboy::opReg<&CPU::subRegCarry, B>;
+    table[SBC_C] = &Gameboy::opReg<&CPU::subRegCarry, C>;
+    table[SBC_D] = &Gameboy::opReg<&CPU::subRegCarry, D>;
+    table[SBC_E] = &Gameboy::opReg<&CPU::subRegCarry, E>;
+    table[SBC_H] = &Gameboy::opReg<&CPU::subRegCarry, H>;
+    table[SBC_L] = &Gameboy::opReg<&CPU::subRegCarry, L>;
+    table[SBC_IND] = &Gameboy::opIndirect<&CPU::subIndirectCarry>;
+    table[SBC_IMM] = &Gameboy::opImm<&CPU::subImmCarry>;
+    table[CP_A] = &Gameboy::opReg<&CPU::compareReg, A>;
+    table[CP_B] = &Gameboy::opReg<&CPU::compareReg, B>;
+    table[CP_C] = &Gameboy::opReg<&CPU::compareReg, C>;
+    table[CP_D] = &Gameboy::opReg<&CPU::compareReg, D>;
+    table[CP_E] = &Gameboy::opReg<&CPU::compareReg, E>;
+    table[CP_H] = &Gameboy::opReg<&CPU::compareReg, H>;
+    table[CP_L] = &Gameboy::opReg<&CPU::compareReg, L>;
+    table[CP_IND] = &Gameboy::opIndirect<&CPU::compareIndirect>;
+    table[CP_IMM] = &Gameboy::opImm<&CPU::compareImm>;
+    table[INC_A] = &Gameboy::opReg<&CPU::incReg, A>;
+    table[INC_B] = &Gameboy::opReg<&CPU::incReg, B>;
+    table[INC_C] = &Gameboy::opReg<&CPU::incReg, C>;
+    table[INC_D] = &Gameboy::opReg<&CPU::incReg, D>;
+    table[INC_E] = &Gameboy::opReg<&CPU::incReg, E>;
+    table[INC_H] = &Gameboy::opReg<&CPU::incReg, H>;
+    table[INC_L] = &Gameboy::opReg<&CPU::incReg, L>;
+    table[INC_IND] = &Gameboy::opIndirect<&CPU::incIndirect>;
+    table[DEC_A] = &Gameboy::opReg<&CPU::decReg, A>;
+    table[DEC_B] = &Gameboy::opReg<&CPU::decReg, B>;
+    table[DEC_C] = &Gameboy::opReg<&CPU::decReg, C>;
+    table[DEC_D] = &Gameboy::opReg<&CPU::decReg, D>;
+    table[DEC_E] = &Gameboy::opReg<&CPU::decReg, E>;
+    table[DEC_H] = &Gameboy::opReg<&CPU::decReg, H>;
+    table[DEC_L] = &Gameboy::opReg<&CPU::decReg, L>;
+    table[DEC_IND] = &Gameboy::opIndirect<&CPU::decIndirect>;
+    table[AND_A] = &Gameboy::opReg<&CPU::andReg, A>;
+    table[AND_B] = &Gameboy::opReg<&CPU::andReg, B>;
+    table[AND_C] = &Gameboy::opReg<&CPU::andReg, C>;
+    table[AND_D] = &Gameboy::opReg<&CPU::andReg, D>;
+    table[AND_E] = &Gameboy::opReg<&CPU::andReg, E>;
+    table[AND_H] = &Gameboy::opReg<&CPU::andReg, H>;
+    table[AND_L] = &Gameboy::opReg<&CPU::andReg, L>;
+    table[AND_IND] = &Gameboy::opIndirect<&CPU::andIndirect>;
+    table[AND_IMM] = &Gameboy::opImm<&CPU::andImm>;
+    table[OR_A] = &Gameboy::opReg<&CPU::orReg, A>;
+    table[OR_B] = &Gameboy::opReg<&CPU::orReg, B>;
+    table[OR_C] = &Gameboy::opReg<&CPU::orReg, C>;
+    table[OR_D] = &Gameboy::opReg<&CPU::orReg, D>;
+    table[OR_E] = &Gameboy::opReg<&CPU::orReg, E>;
+    table[OR_H] = &Gameboy::opReg<&CPU::orReg, H>;
+    table[OR_L] = &Gameboy::opReg<&CPU::orReg, L>;
+    table[OR_IND] = &Gameboy::opIndirect<&CPU::orIndirect>;
+    table[OR_IMM] = &Gameboy::opImm<&CPU::orImm>;
+    table[XOR_A] = &Gameboy::opReg<&CPU::xorReg, A>;
+    table[XOR_B] = &Gameboy::opReg<&CPU::xorReg, B>;
+    table[XOR_C] = &Gameboy::opReg<&CPU::xorReg, C>;
+    table[XOR_D] = &Gameboy::opReg<&CPU::xorReg, D>;
+    table[XOR_E] = &Gameboy::opReg<&CPU::xorReg, E>;
+    table[XOR_H] = &Gameboy::opReg<&CPU::xorReg, H>;
+    table[XOR_L] = &Gameboy::opReg<&CPU::xorReg, L>;
+    table[XOR_IND] = &Gameboy::opIndirect<&CPU::xorIndirect>;
+    table[XOR_IMM] = &Gameboy::opImm<&CPU::xorImm>;
+    table[CCF] = &Gameboy::opImplied<&CPU::compCarryFlag>;
+    table[SCF] = &Gameboy::opImplied<&CPU::setCarryFlag>;
+    table[DAA] = &Gameboy::opImplied<&CPU::decimalAdjustAcc>;
+    table[CPL] = &Gameboy::opImplied<&CPU::compAcc>;
+    table[INC_BC] = &Gameboy::opImplied<&CPU::incBC>;
+    table[INC_DE] = &Gameboy::opImplied<&CPU::incDE>;
+    table[INC_HL] = &Gameboy::opImplied<&CPU::incHL>;
+    table[INC_SP] = &Gameboy::opImplied<&CPU::incSP>;
+    table[DEC_BC] = &Gameboy::opImplied<&CPU::decBC>;
+    table[DEC_DE] = &Gameboy::opImplied<&CPU::decDE>;
+    table[DEC_HL] = &Gameboy::opImplied<&CPU::decHL>;
+    table[DEC_SP] = &Gameboy::opImplied<&CPU::decSP>;
+    table[ADD_HL_BC] = &Gameboy::opAddHLRegPair<B, C>;
+    table[ADD_HL_DE] = &Gameboy::opAddHLRegPair<D, E>;
+    table[ADD_HL_HL] = &Gameboy::opAddHLRegPair<H, L>;
+    table[ADD_HL_SP] = &Gameboy::opImplied<&CPU::addHLSP>;
+    table[LD_HL_SP_OFFSET] = &Gameboy::opOffsetDelayed<&CPU::loadHLSPOffset>;
+    table[ADD_SP_IMM] = &Gameboy::opOffset<&CPU::addSPImm>;
+    table[JP] = &Gameboy::opJump;
+    table[JP_HL] = &Gameboy::opJumpHL;
+    table[JP_C] = &Gameboy::opJumpCond<CARRY>;
+    table[JP_NC] = &Gameboy::opJumpCond<NO_CARRY>;
+    table[JP_Z] = &Gameboy::opJumpCond<ZERO>;
+    table[JP_NZ] = &Gameboy::opJumpCond<NOT_ZERO>;
+    table[JR] = &Gameboy::opJumpRel;
+    table[JR_C] = &Gameboy::opJumpRelCond<CARRY>;
+    table[JR_NC] = &Gameboy::opJumpRelCond<NO_CARRY>;
+    table[JR_Z] = &Gameboy::opJumpRelCond<ZERO>;
+    table[JR_NZ] = &Gameboy::opJumpRelCond<NOT_ZERO>;
+    table[CALL] = &Gameboy::opCall;
+    table[CALL_C] = &Gameboy::opCallCond<CARRY>;
+    table[CALL_NC] = &Gameboy::opCallCond<NO_CARRY>;
+    table[CALL_Z] = &Gameboy::opCallCond<ZERO>;
+    table[CALL_NZ] = &Gameboy::opCallCond<NOT_ZERO>;
+    table[RET] = &Gameboy::opRet;
+    table[RET_C] = &Gameboy::opRetCond<CARRY>;
+    table[RET_NC] = &Gameboy::opRetCond<NO_CARRY>;
+    table[RET_Z] = &Gameboy::opRetCond<ZERO>;
+    table[RET_NZ] = &Gameboy::opRetCond<NOT_ZERO>;
+    table[RETI] = &Gameboy::opReti;
+    table[RST_0x00] = &Gameboy::opRst<0x00>;
+    table[RST_0x08] = &Gameboy::opRst<0x08>;
+    table[RST_0x10] = &Gameboy::opRst<0x10>;
+    table[RST_0x18] = &Gameboy::opRst<0x18>;
+    table[RST_0x20] = &Gameboy::opRst<0x20>;
+    table[RST_0x28] = &Gameboy::opRst<0x28>;
+    table[RST_0x30] = &Gameboy::opRst<0x30>;
+    table[RST_0x38] = &Gameboy::opRst<0x38>;
+    table[RRCA] = &Gameboy::opRotateA<&CPU::rrc>;
+    table[RRA] = &Gameboy::opRotateA<&CPU::rr>;
+    table[RLA] = &Gameboy::opRotateA<&CPU::rl>;
+    table[RLCA] = &Gameboy::opRotateA<&CPU::rlc>;
+    table[CB_OP] = &Gameboy::opCB;
+    return table;
+}
+
+std::array<Gameboy::OpHandler, 256> Gameboy::buildCbTable(){
+    std::array<OpHandler, 256> table;
+    table[RRC_A] = &Gameboy::cbRotate<&CPU::rrc, A>;
+    table[RRC_B] = &Gameboy::cbRotate<&CPU::rrc, B>;
+    table[RRC_C] = &Gameboy::cbRotate<&CPU::rrc, C>;
+    table[RRC_D] = &Gameboy::cbRotate<&CPU::rrc, D>;
+    table[RRC_E] = &Gameboy::cbRotate<&CPU::rrc, E>;
+    table[RRC_H] = &Gameboy::cbRotate<&CPU::rrc, H>;
+    table[RRC_L] = &Gameboy::cbRotate<&CPU::rrc, L>;
+    table[RRC_IND] = &Gameboy::cbIndirect<&CPU::rrcInd>;
+    table[RR_A] = &Gameboy::cbRotate<&CPU::rr, A>;
+    table[RR_B] = &Gameboy::cbRotate<&CPU::rr, B>;
+    table[RR_C] = &Gameboy::cbRotate<&CPU::rr, C>;
+    table[RR_D] = &Gameboy::cbRotate<&CPU::rr, D>;
+    table[RR_E] = &Gameboy::cbRotate<&CPU::rr, E>;
+    table[RR_H] = &Gameboy::cbRotate<&CPU::rr, H>;
+    table[RR_L] = &Gameboy::cbRotate<&CPU::rr, L>;
+    table[RR_IND] = &Gameboy::cbIndirect<&CPU::rrInd>;
+    table[RLC_A] = &Gameboy::cbRotate<&CPU::rlc, A>;
+    table[RLC_B] = &Gameboy::cbRotate<&CPU::rlc, B>;
+    table[RLC_C] = &Gameboy::cbRotate<&CPU::rlc, C>;
+    table[RLC_D] = &Gameboy::cbRotate<&CPU::rlc, D>;
+    table[RLC_E] = &Gameboy::cbRotate<&CPU::rlc, E>;
+    table[RLC_H] = &Gameboy::cbRotate<&CPU::rlc, H>;
+    table[RLC_L] = &Gameboy::cbRotate<&CPU::rlc, L>;
+    table[RLC_IND] = &Gameboy::cbIndirect<&CPU::rlcInd>;
+    table[RL_A] = &Gameboy::cbRotate<&CPU::rl, A>;
+    table[RL_B] = &Gameboy::cbRotate<&CPU::rl, B>;
+    table[RL_C] = &Gameboy::cbRotate<&CPU::rl, C>;
+    table[RL_D] = &Gameboy::cbRotate<&CPU::rl, D>;
+    table[RL_E] = &Gameboy::cbRotate<&CPU::rl, E>;
+    table[RL_H] = &Gameboy::cbRotate<&CPU::rl, H>;
+    table[RL_L] = &Gameboy::cbRotate<&CPU::rl, L>;
+    table[RL_IND] = &Gameboy::cbIndirect<&CPU::rlInd>;
+    table[SLA_A] = &Gameboy::cbShift<&CPU::sla, A>;
+    table[SLA_B] = &Gameboy::cbShift<&CPU::sla, B>;
+    table[SLA_C] = &Gameboy::cbShift<&CPU::sla, C>;
+    table[SLA_D] = &Gameboy::cbShift<&CPU::sla, D>;
+    table[SLA_E] = &Gameboy::cbShift<&CPU::sla, E>;
+    table[SLA_H] = &Gameboy::cbShift<&CPU::sla, H>;
+    table[SLA_L] = &Gameboy::cbShift<&CPU::sla, L>;
+    table[SLA_IND] = &Gameboy::cbIndirect<&CPU::slaInd>;
+    table[SRA_A] = &Gameboy::cbShift<&CPU::sra, A>;
+    table[SRA_B] = &Gameboy::cbShift<&CPU::sra, B>;
+    table[SRA_C] = &Gameboy::cbShift<&CPU::sra, C>;
+    table[SRA_D] = &Gameboy::cbShift<&CPU::sra, D>;
+    table[SRA_E] = &Gameboy::cbShift<&CPU::sra, E>;
+    table[SRA_H] = &Gameboy::cbShift<&CPU::sra, H>;
+    table[SRA_L] = &Gameboy::cbShift<&CPU::sra, L>;
+    table[SRA_IND] = &Gameboy::cbIndirect<&CPU::sraInd>;
+    table[SRL_A] = &Gameboy::cbShift<&CPU::srl, A>;
+    table[SRL_B] = &Gameboy::cbShift<&CPU::srl, B>;
+    table[SRL_C] = &Gameboy::cbShift<&CPU::srl, C>;
+    table[SRL_D] = &Gameboy::cbShift<&CPU::srl, D>;
+    table[SRL_E] = &Gameboy::cbShift<&CPU::srl, E>;
+    table[SRL_H] = &Gameboy::cbShift<&CPU::srl, H>;
+    table[SRL_L] = &Gameboy::cbShift<&CPU::srl, L>;
+    table[SRL_IND] = &Gameboy::cbIndirect<&CPU::srlInd>;
+    table[SWAP_A] = &Gameboy::cbShift<&CPU::swap, A>;
+    table[SWAP_B] = &Gameboy::cbShift<&CPU::swap, B>;
+    table[SWAP_C] = &Gameboy::cbShift<&CPU::swap, C>;
+    table[SWAP_D] = &Gameboy::cbShift<&CPU::swap, D>;
+    table[SWAP_E] = &Gameboy::cbShift<&CPU::swap, E>;
+    table[SWAP_H] = &Gameboy::cbShift<&CPU::swap, H>;
+    table[SWAP_L] = &Gameboy::cbShift<&CPU::swap, L>;
+    table[SWAP_IND] = &Gameboy::cbIndirect<&CPU::swapInd>;
+    table[BIT_0_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_ZERO>;
+    table[BIT_1_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_ONE>;
+    table[BIT_2_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_TWO>;
+    table[BIT_3_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_THREE>;
+    table[BIT_4_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_FOUR>;
+    table[BIT_5_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_FIVE>;
+    table[BIT_6_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_SIX>;
+    table[BIT_7_A] = &Gameboy::cbBit<&CPU::bit, A, BIT_SEVEN>;
+    table[BIT_0_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_ZERO>;
+    table[BIT_1_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_ONE>;
+    table[BIT_2_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_TWO>;
+    table[BIT_3_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_THREE>;
+    table[BIT_4_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_FOUR>;
+    table[BIT_5_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_FIVE>;
+    table[BIT_6_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_SIX>;
+    table[BIT_7_B] = &Gameboy::cbBit<&CPU::bit, B, BIT_SEVEN>;
+    table[BIT_0_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_ZERO>;
+    table[BIT_1_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_ONE>;
+    table[BIT_2_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_TWO>;
+    table[BIT_3_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_THREE>;
+    table[BIT_4_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_FOUR>;
+    table[BIT_5_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_FIVE>;
+    table[BIT_6_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_SIX>;
+    table[BIT_7_C] = &Gameboy::cbBit<&CPU::bit, C, BIT_SEVEN>;
+    table[BIT_0_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_ZERO>;
+    table[BIT_1_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_ONE>;
+    table[BIT_2_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_TWO>;
+    table[BIT_3_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_THREE>;
+    table[BIT_4_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_FOUR>;
+    table[BIT_5_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_FIVE>;
+    table[BIT_6_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_SIX>;
+    table[BIT_7_D] = &Gameboy::cbBit<&CPU::bit, D, BIT_SEVEN>;
+    table[BIT_0_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_ZERO>;
+    table[BIT_1_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_ONE>;
+    table[BIT_2_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_TWO>;
+    table[BIT_3_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_THREE>;
+    table[BIT_4_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_FOUR>;
+    table[BIT_5_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_FIVE>;
+    table[BIT_6_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_SIX>;
+    table[BIT_7_E] = &Gameboy::cbBit<&CPU::bit, E, BIT_SEVEN>;
+    table[BIT_0_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_ZERO>;
+    table[BIT_1_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_ONE>;
+    table[BIT_2_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_TWO>;
+    table[BIT_3_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_THREE>;
+    table[BIT_4_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_FOUR>;
+    table[BIT_5_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_FIVE>;
+    table[BIT_6_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_SIX>;
+    table[BIT_7_H] = &Gameboy::cbBit<&CPU::bit, H, BIT_SEVEN>;
+    table[BIT_0_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_ZERO>;
+    table[BIT_1_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_ONE>;
+    table[BIT_2_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_TWO>;
+    table[BIT_3_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_THREE>;
+    table[BIT_4_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_FOUR>;
+    table[BIT_5_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_FIVE>;
+    table[BIT_6_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_SIX>;
+    table[BIT_7_L] = &Gameboy::cbBit<&CPU::bit, L, BIT_SEVEN>;
+    table[BIT_0_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_ZERO>;
+    table[BIT_1_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_ONE>;
+    table[BIT_2_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_TWO>;
+    table[BIT_3_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_THREE>;
+    table[BIT_4_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_FOUR>;
+    table[BIT_5_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_FIVE>;
+    table[BIT_6_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_SIX>;
+    table[BIT_7_IND] = &Gameboy::cbBitIndirect<&CPU::bitInd, BIT_SEVEN>;
+    table[RES_0_A] = &Gameboy::cbBit<&CPU::res, A, BIT_ZERO>;
+    table[RES_1_A] = &Gameboy::cbBit<&CPU::res, A, BIT_ONE>;
+    table[RES_2_A] = &Gameboy::cbBit<&CPU::res, A, BIT_TWO>;
+    table[RES_3_A] = &Gameboy::cbBit<&CPU::res, A, BIT_THREE>;
+    table[RES_4_A] = &Gameboy::cbBit<&CPU::res, A, BIT_FOUR>;
+    table[RES_5_A] = &Gameboy::cbBit<&CPU::res, A, BIT_FIVE>;
+    table[RES_6_A] = &Gameboy::cbBit<&CPU::res, A, BIT_SIX>;
+    table[RES_7_A] = &Gameboy::cbBit<&CPU::res, A, BIT_SEVEN>;
+    table[RES_0_B] = &Gameboy::cbBit<&CPU::res, B, BIT_ZERO>;
+    table[RES_1_B] = &Gameboy::cbBit<&CPU::res, B, BIT_ONE>;
+    table[RES_2_B] = &Gameboy::cbBit<&CPU::res, B, BIT_TWO>;
+    table[RES_3_B] = &Gameboy::cbBit<&CPU::res, B, BIT_THREE>;
+    table[RES_4_B] = &Gameboy::cbBit<&CPU::res, B, BIT_FOUR>;
+    table[RES_5_B] = &Gameboy::cbBit<&CPU::res, B, BIT_FIVE>;
+    table[RES_6_B] = &Gameboy::cbBit<&CPU::res, B, BIT_SIX>;
+    table[RES_7_B] = &Gameboy::cbBit<&CPU::res, B, BIT_SEVEN>;
+    table[RES_0_C] = &Gameboy::cbBit<&CPU::res, C, BIT_ZERO>;
+    table[RES_1_C] = &Gameboy::cbBit<&CPU::res, C, BIT_ONE>;
+    table[RES_2_C] = &Gameboy::cbBit<&CPU::res, C, BIT_TWO>;
+    table[RES_3_C] = &Gameboy::cbBit<&CPU::res, C, BIT_THREE>;
+    table[RES_4_C] = &Gameboy::cbBit<&CPU::res, C, BIT_FOUR>;
+    table[RES_5_C] = &Gameboy::cbBit<&CPU::res, C, BIT_FIVE>;
+    table[RES_6_C] = &Gameboy::cbBit<&CPU::res, C, BIT_SIX>;
+    table[RES_7_C] = &Gameboy::cbBit<&CPU::res, C, BIT_SEVEN>;
+    table[RES_0_D] = &Gameboy::cbBit<&CPU::res, D, BIT_ZERO>;
+    table[RES_1_D] = &Gameboy::cbBit<&CPU::res, D, BIT_ONE>;
+    table[RES_2_D] = &Gameboy::cbBit<&CPU::res, D, BIT_TWO>;
+    table[RES_3_D] = &Gameboy::cbBit<&CPU::res, D, BIT_THREE>;
+    table[RES_4_D] = &Gameboy::cbBit<&CPU::res, D, BIT_FOUR>;
+    table[RES_5_D] = &Gameboy::cbBit<&CPU::res, D, BIT_FIVE>;
+    table[RES_6_D] = &Gameboy::cbBit<&CPU::res, D, BIT_SIX>;
+    table[RES_7_D] = &Gameboy::cbBit<&CPU::res, D, BIT_SEVEN>;
+    table[RES_0_E] = &Gameboy::cbBit<&CPU::res, E, BIT_ZERO>;
+    table[RES_1_E] = &Gameboy::cbBit<&CPU::res, E, BIT_ONE>;
+    table[RES_2_E] = &Gameboy::cbBit<&CPU::res, E, BIT_TWO>;
+    table[RES_3_E] = &Gameboy::cbBit<&CPU::res, E, BIT_THREE>;
+    table[RES_4_E] = &Gameboy::cbBit<&CPU::res, E, BIT_FOUR>;
+    table[RES_5_E] = &Gameboy::cbBit<&CPU::res, E, BIT_FIVE>;
+    table[RES_6_E] = &Gameboy::cbBit<&CPU::res, E, BIT_SIX>;
+    table[RES_7_E] = &Gameboy::cbBit<&CPU::res, E, BIT_SEVEN>;
+    table[RES_0_H] = &Gameboy::cbBit<&CPU::res, H, BIT_ZERO>;
+    table[RES_1_H] = &Gameboy::cbBit<&CPU::res, H, BIT_ONE>;
+    table[RES_2_H] = &Gameboy::cbBit<&CPU::res, H, BIT_TWO>;
+    table[RES_3_H] = &Gameboy::cbBit<&CPU::res, H, BIT_THREE>;
+    table[RES_4_H] = &Gameboy::cbBit<&CPU::res, H, BIT_FOUR>;
+    table[RES_5_H] = &Gameboy::cbBit<&CPU::res, H, BIT_FIVE>;
+    table[RES_6_H] = &Gameboy::cbBit<&CPU::res, H, BIT_SIX>;
+    table[RES_7_H] = &Gameboy::cbBit<&CPU::res, H, BIT_SEVEN>;
+    table[RES_0_L] = &Gameboy::cbBit<&CPU::res, L, BIT_ZERO>;
+    table[RES_1_L] = &Gameboy::cbBit<&CPU::res, L, BIT_ONE>;
+    table[RES_2_L] = &Gameboy::cbBit<&CPU::res, L, BIT_TWO>;
+    table[RES_3_L] = &Gameboy::cbBit<&CPU::res, L, BIT_THREE>;
+    table[RES_4_L] = &Gameboy::cbBit<&CPU::res, L, BIT_FOUR>;
+    table[RES_5_L] = &Gameboy::cbBit<&CPU::res, L, BIT_FIVE>;
+    table[RES_6_L] = &Gameboy::cbBit<&CPU::res, L, BIT_SIX>;
+    table[RES_7_L] = &Gameboy::cbBit<&CPU::res, L, BIT_SEVEN>;
+    table[RES_0_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_ZERO>;
+    table[RES_1_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_ONE>;
+    table[RES_2_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_TWO>;
+    table[RES_3_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_THREE>;
+    table[RES_4_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_FOUR>;
+    table[RES_5_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_FIVE>;
+    table[RES_6_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_SIX>;
+    table[RES_7_IND] = &Gameboy::cbBitIndirect<&CPU::resInd, BIT_SEVEN>;
+    table[SET_0_A] = &Gameboy::cbBit<&CPU::set, A, BIT_ZERO>;
+    table[SET_1_A] = &Gameboy::cbBit<&CPU::set, A, BIT_ONE>;
+    table[SET_2_A] = &Gameboy::cbBit<&CPU::set, A, BIT_TWO>;
+    table[SET_3_A] = &Gameboy::cbBit<&CPU::set, A, BIT_THREE>;
+    table[SET_4_A] = &Gameboy::cbBit<&CPU::set, A, BIT_FOUR>;
+    table[SET_5_A] = &Gameboy::cbBit<&CPU::set, A, BIT_FIVE>;
+    table[SET_6_A] = &Gameboy::cbBit<&CPU::set, A, BIT_SIX>;
+    table[SET_7_A] = &Gameboy::cbBit<&CPU::set, A, BIT_SEVEN>;
+    table[SET_0_B] = &Gameboy::cbBit<&CPU::set, B, BIT_ZERO>;
+    table[SET_1_B] = &Gameboy::cbBit<&CPU::set, B, BIT_ONE>;
+    table[SET_2_B] = &Gameboy::cbBit<&CPU::set, B, BIT_TWO>;
+    table[SET_3_B] = &Gameboy::cbBit<&CPU::set, B, BIT_THREE>;
+    table[SET_4_B] = &Gameboy::cbBit<&CPU::set, B, BIT_FOUR>;
+    table[SET_5_B] = &Gameboy::cbBit<&CPU::set, B, BIT_FIVE>;
+    table[SET_6_B] = &Gameboy::cbBit<&CPU::set, B, BIT_SIX>;
+    table[SET_7_B] = &Gameboy::cbBit<&CPU::set, B, BIT_SEVEN>;
+    table[SET_0_C] = &Gameboy::cbBit<&CPU::set, C, BIT_ZERO>;
+    table[SET_1_C] = &Gameboy::cbBit<&CPU::set, C, BIT_ONE>;
+    table[SET_2_C] = &Gameboy::cbBit<&CPU::set, C, BIT_TWO>;
+    table[SET_3_C] = &Gameboy::cbBit<&CPU::set, C, BIT_THREE>;
+    table[SET_4_C] = &Gameboy::cbBit<&CPU::set, C, BIT_FOUR>;
+    table[SET_5_C] = &Gameboy::cbBit<&CPU::set, C, BIT_FIVE>;
+    table[SET_6_C] = &Gameboy::cbBit<&CPU::set, C, BIT_SIX>;
+    table[SET_7_C] = &Gameboy::cbBit<&CPU::set, C, BIT_SEVEN>;
+    table[SET_0_D] = &Gameboy::cbBit<&CPU::set, D, BIT_ZERO>;
+    table[SET_1_D] = &Gameboy::cbBit<&CPU::set, D, BIT_ONE>;
+    table[SET_2_D] = &Gameboy::cbBit<&CPU::set, D, BIT_TWO>;
+    table[SET_3_D] = &Gameboy::cbBit<&CPU::set, D, BIT_THREE>;
+    table[SET_4_D] = &Gameboy::cbBit<&CPU::set, D, BIT_FOUR>;
+    table[SET_5_D] = &Gameboy::cbBit<&CPU::set, D, BIT_FIVE>;
+    table[SET_6_D] = &Gameboy::cbBit<&CPU::set, D, BIT_SIX>;
+    table[SET_7_D] = &Gameboy::cbBit<&CPU::set, D, BIT_SEVEN>;
+    table[SET_0_E] = &Gameboy::cbBit<&CPU::set, E, BIT_ZERO>;
+    table[SET_1_E] = &Gameboy::cbBit<&CPU::set, E, BIT_ONE>;
+    table[SET_2_E] = &Gameboy::cbBit<&CPU::set, E, BIT_TWO>;
+    table[SET_3_E] = &Gameboy::cbBit<&CPU::set, E, BIT_THREE>;
+    table[SET_4_E] = &Gameboy::cbBit<&CPU::set, E, BIT_FOUR>;
+    table[SET_5_E] = &Gameboy::cbBit<&CPU::set, E, BIT_FIVE>;
+    table[SET_6_E] = &Gameboy::cbBit<&CPU::set, E, BIT_SIX>;
+    table[SET_7_E] = &Gameboy::cbBit<&CPU::set, E, BIT_SEVEN>;
+    table[SET_0_H] = &Gameboy::cbBit<&CPU::set, H, BIT_ZERO>;
+    table[SET_1_H] = &Gameboy::cbBit<&CPU::set, H, BIT_ONE>;
+    table[SET_2_H] = &Gameboy::cbBit<&CPU::set, H, BIT_TWO>;
+    table[SET_3_H] = &Gameboy::cbBit<&CPU::set, H, BIT_THREE>;
+    table[SET_4_H] = &Gameboy::cbBit<&CPU::set, H, BIT_FOUR>;
+    table[SET_5_H] = &Gameboy::cbBit<&CPU::set, H, BIT_FIVE>;
+    table[SET_6_H] = &Gameboy::cbBit<&CPU::set, H, BIT_SIX>;
+    table[SET_7_H] = &Gameboy::cbBit<&CPU::set, H, BIT_SEVEN>;
+    table[SET_0_L] = &Gameboy::cbBit<&CPU::set, L, BIT_ZERO>;
+    table[SET_1_L] = &Gameboy::cbBit<&CPU::set, L, BIT_ONE>;
+    table[SET_2_L] = &Gameboy::cbBit<&CPU::set, L, BIT_TWO>;
+    table[SET_3_L] = &Gameboy::cbBit<&CPU::set, L, BIT_THREE>;
+    table[SET_4_L] = &Gameboy::cbBit<&CPU::set, L, BIT_FOUR>;
+    table[SET_5_L] = &Gameboy::cbBit<&CPU::set, L, BIT_FIVE>;
+    table[SET_6_L] = &Gameboy::cbBit<&CPU::set, L, BIT_SIX>;
+    table[SET_7_L] = &Gameboy::cbBit<&CPU::set, L, BIT_SEVEN>;
+    table[SET_0_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_ZERO>;
+    table[SET_1_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_ONE>;
+    table[SET_2_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_TWO>;
+    table[SET_3_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_THREE>;
+    table[SET_4_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_FOUR>;
+    table[SET_5_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_FIVE>;
+    table[SET_6_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_SIX>;
+    table[SET_7_IND] = &Gameboy::cbBitIndirect<&CPU::setInd, BIT_SEVEN>;
+    return table;
+}
@@ -0,0 +1,44 @@
+#include "display.h"
+
+Display::Display(){
+    window = SDL_CreateWindow("JBoy",
+        SDL_WINDOWPOS_CENTERED,
+        SDL_WINDOWPOS_CENTERED,
+        WIN_DIMENSION_SCALE_FACTOR * SCREEN_WIDTH,
+        WIN_DIMENSION_SCALE_FACTOR * SCREEN_HEIGHT,
+        SDL_WINDOW_ALLOW_HIGHDPI);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    frameTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+Display::~Display(){
+    SDL_DestroyTexture(frameTexture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+}
+
+FrameBuffer& Display::nextFrame(){
+    return frames.getBack();
+}
+
+void Display::submitFrame(){
+    frames.publish();
+}
+
+bool Display::present(){
+    if(!frames.fetch()){
+        return false;
+    }
+    SDL_UpdateTexture(frameTexture, NULL, frames.getFront().data(), SCREEN_WIDTH * sizeof(uint32_t));
+    SDL_RenderCopy(renderer, frameTexture, NULL, NULL);
+    SDL_RenderPresent(renderer);
+    return true;
+}
+
+int Display::getRefreshRate(){
+    SDL_DisplayMode displayMode;
+    if(SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &displayMode) != 0){
+        return 0;
+    }
+    return displayMode.refresh_rate;
+}
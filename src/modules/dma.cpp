@@ -1,20 +1,34 @@
 #include "memory.h"
 #include "dma.h"
 #include <iostream>
+#include <algorithm>
 
-DMA::DMA() : mem(DMA_PERM), dmaReg(mem.getRegister(DMA_REG)){
+DMA::DMA(Bus& bus) : mem(bus), dmaReg(mem.getRegister(DMA_REG)){
     state = POLLING;
     cyclesLeft = DMA_CYCLES;
+    requested = false;
+    requestedSrc = 0;
+    mem.onWrite(DMA_REG, [this](Regval8 byte){
+        request(byte);
+    });
+}
+
+//writing 0 drops a request that hasn't been picked up yet
+void DMA::request(Regval8 byte){
+    requested = byte != 0;
+    requestedSrc = byte;
 }
 
 void DMA::emulateCycle(){
     switch (state){
     case POLLING:
-        if(dmaReg){
-            regVal = dmaReg;
+        if(requested){
+            requested = false;
+            regVal = requestedSrc;
             dmaReg = 0x00; //reset the register for next request
             state = TRANSFERING;
             cyclesLeft = DMA_CYCLES;
+            mem.lockMemoryDMA();
             break;
         }
         break;
@@ -28,6 +42,7 @@ void DMA::emulateCycle(){
                 dstPtr++;
             }
             state = POLLING;
+            mem.unlockMemoryDMA();
             break;
         }
         cyclesLeft--;
@@ -36,4 +51,34 @@ void DMA::emulateCycle(){
         break;
     }
 
+}
+
+bool DMA::isActive(){
+    return state == TRANSFERING || requested;
+}
+
+void DMA::emulateCycles(int n){
+    while(n > 0){
+        if(state == TRANSFERING && cyclesLeft > 0){
+            int skip = std::min(n, cyclesLeft);
+            cyclesLeft -= skip;
+            n -= skip;
+            continue;
+        }
+        if(state == POLLING && !requested){
+            return;
+        }
+        emulateCycle();
+        n--;
+    }
+}
+
+int DMA::cyclesUntilEvent(){
+    if(state == TRANSFERING){
+        return cyclesLeft;
+    }
+    if(requested){
+        return 0;
+    }
+    return NO_EVENT;
 }
\ No newline at end of file
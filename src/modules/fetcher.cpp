@@ -10,8 +10,8 @@ constexpr int BYTES_PER_TILE = 16;
 constexpr int BYTES_PER_TILE_ROW = 2;
 constexpr int TILE_MAP_BORDER_LEN = 32;
 
-Fetcher::Fetcher() :
-    mem(PPU_PERM), 
+Fetcher::Fetcher(Bus& bus) :
+    mem(bus), 
     lcdcReg(mem.getRegister(LCDC_REG_ADDR)),
     lyReg(mem.getRegister(LY_REG_ADDR)),
     scxReg(mem.getRegister(SCX_REG_ADDR)),
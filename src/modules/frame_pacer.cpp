@@ -0,0 +1,110 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#ifdef __linux__
+#include <time.h>
+#include <cerrno>
+#endif
+
+FramePacer::FramePacer(double rate){
+    spinWindow = INITIAL_SPIN_WINDOW;
+    setRate(rate);
+}
+
+void FramePacer::setRate(double rate){
+    period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    reset();
+}
+
+void FramePacer::reset(){
+    deadline = std::chrono::steady_clock::time_point();
+    numFrames = 0;
+    numTimed = 0;
+    frameSumMs = 0;
+    frameSumSqMs = 0;
+    maxLateMs = 0;
+}
+
+/*
+clock_nanosleep on an absolute CLOCK_MONOTONIC time can't drift from being
+interrupted and restarted, unlike a relative sleep. The deadline is translated
+from steady_clock rather than assuming the two share an epoch.
+*/
+void FramePacer::sleepUntil(std::chrono::steady_clock::time_point time){
+#ifdef __linux__
+    timespec wake;
+    clock_gettime(CLOCK_MONOTONIC, &wake);
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time - std::chrono::steady_clock::now()).count();
+    if(ns <= 0){
+        return;
+    }
+    ns += wake.tv_nsec;
+    wake.tv_sec += ns / 1000000000;
+    wake.tv_nsec = ns % 1000000000;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR);
+#else
+    std::this_thread::sleep_until(time);
+#endif
+}
+
+void FramePacer::adaptSpinWindow(std::chrono::steady_clock::duration oversleep){
+    if(oversleep > spinWindow){
+        spinWindow += SPIN_WINDOW_STEP * (LATE_WAKE_RATIO - 1);
+    }
+    else{
+        spinWindow -= SPIN_WINDOW_STEP;
+    }
+    spinWindow = std::clamp<std::chrono::steady_clock::duration>(spinWindow, MIN_SPIN_WINDOW, MAX_SPIN_WINDOW);
+}
+
+bool FramePacer::onSchedule(std::chrono::steady_clock::time_point now){
+    return numFrames != 0 && now <= deadline + period;
+}
+
+void FramePacer::release(std::chrono::steady_clock::time_point now){
+    if(onSchedule(now)){
+        maxLateMs = std::max(maxLateMs, std::chrono::duration<double, std::milli>(now - deadline).count());
+        double frameMs = std::chrono::duration<double, std::milli>(now - lastFrame).count();
+        frameSumMs += frameMs;
+        frameSumSqMs += frameMs * frameMs;
+        numTimed++;
+        deadline += period;
+    }
+    else{
+        deadline = now + period;
+    }
+    lastFrame = now;
+    numFrames++;
+}
+
+void FramePacer::wait(){
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(onSchedule(now)){
+        std::chrono::steady_clock::time_point wakeAt = deadline - spinWindow;
+        if(now < wakeAt){
+            sleepUntil(wakeAt);
+            adaptSpinWindow(std::chrono::steady_clock::now() - wakeAt);
+        }
+        while((now = std::chrono::steady_clock::now()) < deadline);
+    }
+    release(now);
+}
+
+bool FramePacer::poll(){
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(numFrames != 0 && now < deadline){
+        return false;
+    }
+    release(now);
+    return true;
+}
+
+PacerStats FramePacer::getStats(){
+    PacerStats stats = {numFrames, 0, 0, maxLateMs, std::chrono::duration<double, std::milli>(spinWindow).count()};
+    if(numTimed){
+        stats.meanFrameMs = frameSumMs / numTimed;
+        stats.jitterMs = std::sqrt(std::max(frameSumSqMs / numTimed - stats.meanFrameMs * stats.meanFrameMs, 0.0));
+    }
+    return stats;
+}
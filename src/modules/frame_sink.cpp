@@ -0,0 +1,41 @@
+#include "frame_sink.h"
+
+bool FrameSink::showsFrames(){
+    return true;
+}
+
+NullFrameSink::NullFrameSink() : buffer(new FrameBuffer()){
+}
+
+FrameBuffer& NullFrameSink::nextFrame(){
+    return *buffer;
+}
+
+void NullFrameSink::submitFrame(){
+}
+
+bool NullFrameSink::showsFrames(){
+    return false;
+}
+
+MemoryFrameSink::MemoryFrameSink() : drawing(new FrameBuffer()), last(new FrameBuffer()){
+    numFrames = 0;
+}
+
+FrameBuffer& MemoryFrameSink::nextFrame(){
+    return *drawing;
+}
+
+//Swapped rather than copied, the buffer handed back holds an older frame
+void MemoryFrameSink::submitFrame(){
+    drawing.swap(last);
+    numFrames++;
+}
+
+const FrameBuffer& MemoryFrameSink::getLastFrame(){
+    return *last;
+}
+
+int MemoryFrameSink::getFrameCount(){
+    return numFrames;
+}
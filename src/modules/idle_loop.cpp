@@ -0,0 +1,132 @@
+#include "gameboy.h"
+#include "instructions.h"
+#include <algorithm>
+
+using namespace std;
+
+/*
+Games that wait for a scanline or for vblank by polling LY or STAT in a
+tight loop instead of halting burn host time on iterations that can't
+change anything. A loop is treated as idle once a full pass through it
+ran only instructions without side effects and came back to its head
+with the CPU in exactly the state it left. From there on every pass is
+the same until one of the registers it reads changes, so whole passes
+are skipped up to the next event that could change them.
+*/
+
+const std::array<bool, 256> Gameboy::pollSafeOps = Gameboy::buildPollSafeOps();
+
+std::array<bool, 256> Gameboy::buildPollSafeOps(){
+    std::array<bool, 256> table;
+    table.fill(true);
+    //anything that writes memory, touches the stack or changes control flags
+    const Regval8 unsafe[] = {
+        LD_BC_A, LD_DE_A, LD_HL_B, LD_HL_C, LD_HL_D, LD_HL_E, LD_HL_H, LD_HL_L, LD_HL_A,
+        LD_HL_IMM_IND, LD_HL_A_INC, LD_HL_A_DEC, LDH_IMM_A, LDH_C_A, LD_ADDR_A, LD_DIR_SP,
+        INC_IND, DEC_IND,
+        PUSH_BC, PUSH_DE, PUSH_HL, PUSH_AF, POP_BC, POP_DE, POP_HL, POP_AF,
+        CALL, CALL_NZ, CALL_NC, CALL_Z, CALL_C, RET, RET_NZ, RET_NC, RET_Z, RET_C, RETI,
+        RST_0x00, RST_0x08, RST_0x10, RST_0x18, RST_0x20, RST_0x28, RST_0x30, RST_0x38,
+        HALT, STOP, DI, EI
+    };
+    for(Regval8 op : unsafe){
+        table[op] = false;
+    }
+    return table;
+}
+
+bool Gameboy::isPollSafe(){
+    if(opcode == CB_OP){
+        //everything but BIT writes its result back to (HL)
+        bool indirect = (cb_op & 0x07) == 0x06;
+        bool bitTest = cb_op >= BIT_0_B && cb_op < RES_0_B;
+        return !indirect || bitTest;
+    }
+    return pollSafeOps[opcode];
+}
+
+Regval8 Gameboy::pollSource(Regval16 addr){
+    switch(addr){
+        case LY_REG_ADDR:
+        case STAT_REG_ADDR:
+            return POLL_PPU;
+        case IF_REG_ADDR:
+            return POLL_PPU | POLL_TIMA_OVERFLOW | POLL_JOYPAD;
+        case JOYP_REG_ADDR:
+            return POLL_JOYPAD;
+        case DIV_REG_ADDR:
+            return POLL_DIV;
+        case TIMA_REG_ADDR:
+            //counts up with no event to wait for
+            return POLL_UNBOUNDED;
+        default:
+            //the PPU locks the CPU out of VRAM and OAM, and lets it back in, on mode changes
+            if((addr >= VRAM_START && addr <= VRAM_END) || (addr >= OAM_START && addr <= OAM_END)){
+                return POLL_PPU;
+            }
+            //nothing else the CPU reads is changed by the peripherals, DMA stops skips altogether
+            return 0;
+    }
+}
+
+void Gameboy::trackIdleLoop(Regval16 startPC){
+    if(!isPollSafe()){
+        idleLoop.sideEffects = true;
+    }
+    Regval16 pc = cpu.getPC();
+    //only a jump backwards closes a pass through a loop
+    if(pc > startPC){
+        return;
+    }
+    GbState curr = getState();
+    //what the pass read must not have changed under it either
+    bool repeated = idleLoop.head == pc && !idleLoop.sideEffects && idleLoop.IME == IME &&
+        lastEventCycle < idleLoop.startCycle &&
+        std::equal(curr.regs_8, curr.regs_8 + NUM_REGS_8, idleLoop.cpuState.regs_8) &&
+        std::equal(curr.regs_16, curr.regs_16 + NUM_REGS_16, idleLoop.cpuState.regs_16);
+    if(repeated){
+        skipIdleLoop(peripheralCycles - idleLoop.startCycle);
+    }
+    idleLoop.head = pc;
+    idleLoop.cpuState = curr;
+    idleLoop.IME = IME;
+    idleLoop.sideEffects = false;
+    idleLoop.polled = 0;
+    idleLoop.startCycle = peripheralCycles;
+}
+
+void Gameboy::skipIdleLoop(uint64_t passCycles){
+    if(!passCycles || (idleLoop.polled & POLL_UNBOUNDED) || dma.isActive()){
+        return;
+    }
+    if(rescheduleNeeded){
+        schedulePeripherals();
+        rescheduleNeeded = false;
+    }
+    uint64_t wake = peripheralCycles + MAX_SKIP_CYCLES;
+    //with interrupts on, anything that raises IF can also break the loop
+    if(IME || (idleLoop.polled & POLL_PPU)){
+        wake = std::min(wake, scheduler.getDeadline(PPU_MODE_EVENT));
+    }
+    if(IME || (idleLoop.polled & POLL_TIMA_OVERFLOW)){
+        wake = std::min(wake, scheduler.getDeadline(TIMA_OVERFLOW_EVENT));
+    }
+    if(IME || (idleLoop.polled & POLL_JOYPAD)){
+        wake = std::min(wake, scheduler.getDeadline(JOYPAD_EVENT));
+    }
+    if(idleLoop.polled & POLL_DIV){
+        wake = std::min(wake, scheduler.getDeadline(DIV_INC_EVENT));
+    }
+    if(wake < peripheralCycles){
+        return;
+    }
+    //only passes whose every read lands before the event are skipped
+    uint64_t skip = (wake - peripheralCycles) / passCycles * passCycles;
+    if(!skip){
+        return;
+    }
+    pendingCycles += skip;
+    totalCycles += skip;
+    skipStats.idleLoopCycles += skip;
+    catchUp();
+}
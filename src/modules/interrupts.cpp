@@ -0,0 +1,31 @@
+#include "interrupts.h"
+
+Interrupts::Interrupts(Bus& bus) : bus(bus){
+}
+
+void Interrupts::raise(Regval8 mask){
+    bus.mem[IF_REG_ADDR] |= mask;
+    refresh();
+}
+
+void Interrupts::clear(Regval8 mask){
+    bus.mem[IF_REG_ADDR] &= ~mask;
+    refresh();
+}
+
+void Interrupts::refresh(){
+    bus.pendingInts = bus.mem[IE_REG_ADDR] & bus.mem[IF_REG_ADDR] & ALL_INTS;
+}
+
+//lower bits take priority
+Regval8 Interrupts::highestPending() const{
+    return bus.pendingInts & (~bus.pendingInts + 1);
+}
+
+Regval16 Interrupts::isrAddress(Regval8 mask){
+    Regval16 addr = VBLANK_ISR_ADDR;
+    for(Regval8 bit = VBLANK_INT; bit && bit != mask; bit <<= 1){
+        addr += ISR_SPACING;
+    }
+    return addr;
+}
@@ -0,0 +1,469 @@
+#include "jit.h"
+#include "instructions.h"
+#include <cstring>
+#include <stdexcept>
+
+#ifdef USE_JIT
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/*
+Each SM83 register lives in the host register numbered 8 + its RegIndex_8
+for the whole run, so A is r8b, F is r13b and so on, and every x86 encoding
+below only has to put the index in the low three bits and set REX. Flags
+are produced by the matching x86 instruction and translated from AH with a
+lookup table instead of being computed bit by bit.
+*/
+
+//x86 group 1 ALU opcode extensions
+constexpr uint8_t X86_ADD = 0;
+constexpr uint8_t X86_OR = 1;
+constexpr uint8_t X86_ADC = 2;
+constexpr uint8_t X86_SBB = 3;
+constexpr uint8_t X86_AND = 4;
+constexpr uint8_t X86_SUB = 5;
+constexpr uint8_t X86_XOR = 6;
+constexpr uint8_t X86_CMP = 7;
+//x86 group 2 shift opcode extensions
+constexpr uint8_t X86_ROL = 0;
+constexpr uint8_t X86_ROR = 1;
+constexpr uint8_t X86_RCL = 2;
+constexpr uint8_t X86_RCR = 3;
+constexpr uint8_t X86_SHL = 4;
+constexpr uint8_t X86_SHR = 5;
+constexpr uint8_t X86_SAR = 7;
+//x86 flag bits as LAHF leaves them in AH
+constexpr uint8_t X86_CF = 0x01;
+constexpr uint8_t X86_AF = 0x10;
+constexpr uint8_t X86_ZF = 0x40;
+
+//Register field of an SM83 opcode, 6 being (HL)
+constexpr int NO_REG = -1;
+constexpr int regField[8] = {B, C, D, E, H, L, NO_REG, A};
+//SM83 ALU operation field, in opcode order ADD ADC SUB SBC AND XOR OR CP
+constexpr uint8_t aluOps[8] = {X86_ADD, X86_ADC, X86_SUB, X86_SBB, X86_AND, X86_XOR, X86_OR, X86_CMP};
+//SM83 CB rotate and shift field, in opcode order RLC RRC RL RR SLA SRA SWAP SRL
+constexpr uint8_t shiftOps[8] = {X86_ROL, X86_ROR, X86_RCL, X86_RCR, X86_SHL, X86_SAR, X86_ROL, X86_SHR};
+
+const std::array<uint8_t, 256> Jit::flagsFromAH = Jit::buildFlagsFromAH();
+
+std::array<uint8_t, 256> Jit::buildFlagsFromAH(){
+    std::array<uint8_t, 256> table;
+    for(int ah = 0; ah < 256; ah++){
+        uint8_t flags = 0;
+        if(ah & X86_ZF)
+            flags |= ZERO_FLAG;
+        if(ah & X86_AF)
+            flags |= HALF_CARRY_FLAG;
+        if(ah & X86_CF)
+            flags |= CARRY_FLAG;
+        table[ah] = flags;
+    }
+    return table;
+}
+
+Jit::Jit(Bus& bus) : mem(bus), bus(bus){
+#ifdef _WIN32
+    void* buf = VirtualAlloc(nullptr, JIT_CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    void* buf = mmap(nullptr, JIT_CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(buf == MAP_FAILED){
+        buf = nullptr;
+    }
+#endif
+    if(!buf){
+        throw std::runtime_error("Jit::Jit(): Could not allocate executable memory.");
+    }
+    codeBuf = (uint8_t*)buf;
+    codeUsed = 0;
+    recent.fill({0, nullptr});
+    try{
+        setWritable(false);
+    }catch(...){
+        freeCode();
+        throw;
+    }
+}
+
+Jit::~Jit(){
+    freeCode();
+}
+
+void Jit::freeCode(){
+#ifdef _WIN32
+    VirtualFree(codeBuf, 0, MEM_RELEASE);
+#else
+    munmap(codeBuf, JIT_CODE_SIZE);
+#endif
+}
+
+/*
+The code buffer is never writable and executable at once, it's only made
+writable for as long as a run is copied in and goes back to executable
+before anything can jump into it.
+*/
+void Jit::setWritable(bool writable){
+#ifdef _WIN32
+    DWORD oldProtect;
+    bool ok = VirtualProtect(codeBuf, JIT_CODE_SIZE, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &oldProtect);
+    if(ok && !writable){
+        FlushInstructionCache(GetCurrentProcess(), codeBuf, JIT_CODE_SIZE);
+    }
+#else
+    bool ok = mprotect(codeBuf, JIT_CODE_SIZE, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) == 0;
+#endif
+    if(!ok){
+        throw std::runtime_error("Jit::setWritable(): Could not change code memory protection.");
+    }
+}
+
+void Jit::flush(){
+    runs.clear();
+    recent.fill({0, nullptr});
+    codeUsed = 0;
+}
+
+const JitRun* Jit::lookup(Regval16 addr){
+    Regval16 regionEnd;
+    int bank;
+    //code outside ROM can be written to, so it's never compiled
+    if(addr <= ROM_BANK_0_END){
+        regionEnd = ROM_BANK_0_END;
+        bank = bus.romBank0;
+    }
+    else if(addr <= ROM_BANK_N_END){
+        regionEnd = ROM_BANK_N_END;
+        bank = bus.currRomBank;
+    }
+    else{
+        return nullptr;
+    }
+    uint32_t key = ((uint32_t)bank << 16) | addr;
+    RecentRun& slot = recent[addr % JIT_RECENT_RUNS];
+    if(!slot.run || slot.key != key){
+        JitRun& run = runs.emplace(key, JitRun{nullptr, 0, true, 0, 0, 0, 0}).first->second;
+        slot = {key, &run};
+    }
+    JitRun& run = *slot.run;
+    if(run.code || !run.compilable){
+        return run.code ? &run : nullptr;
+    }
+    if(++run.hits >= JIT_HOT_THRESHOLD){
+        compile(run, addr, regionEnd);
+    }
+    return run.code ? &run : nullptr;
+}
+
+void Jit::execute(const JitRun* run, CPU& cpu){
+    //compiled code keeps F up to date itself
+    cpu.resolveFlags();
+    run->code(cpu.regs_8);
+    cpu.regs_16[PC] += run->length;
+}
+
+void Jit::compile(JitRun& run, Regval16 addr, Regval16 regionEnd){
+    out.clear();
+    int numOps = 0;
+    Regval16 pc = addr;
+    while(numOps < JIT_MAX_RUN_OPS){
+        Regval8 bytes[3];
+        bytes[0] = mem.read(pc);
+        int length = opLength(bytes[0]);
+        //an instruction straddling the end of the region is left to the interpreter
+        if(regionEnd - pc + 1 < length){
+            break;
+        }
+        for(int i = 1; i < length; i++){
+            bytes[i] = mem.read(pc + i);
+        }
+        size_t mark = out.size();
+        bool compiled = bytes[0] == CB_OP ? emitCbOp(bytes[1]) : emitOp(bytes[0], bytes + 1);
+        if(!compiled){
+            out.resize(mark);
+            break;
+        }
+        run.lastOpcode = bytes[0];
+        run.lastCbOp = bytes[0] == CB_OP ? bytes[1] : 0;
+        pc += length;
+        numOps++;
+        if(pc - 1 == regionEnd){
+            break;
+        }
+    }
+    if(numOps < JIT_MIN_RUN_OPS){
+        run.compilable = false;
+        return;
+    }
+    //every compiled op takes one M-cycle per byte
+    run.length = pc - addr;
+    run.mCycles = run.length;
+
+    std::vector<uint8_t> body;
+    body.swap(out);
+    //prologue: save callee-saved registers and load the SM83 registers
+#ifdef _WIN32
+    emit({0x57});                                   //push rdi
+    emit({0x48, 0x89, 0xCF});                       //mov rdi, rcx
+#endif
+    emit({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});  //push rbx, r12-r15
+    emit({0x48, 0xBB});                             //mov rbx, flagsFromAH
+    uintptr_t table = (uintptr_t)flagsFromAH.data();
+    for(int i = 0; i < 8; i++){
+        out.push_back((table >> (8 * i)) & 0xFF);
+    }
+    for(uint8_t i = 0; i < NUM_REGS_8; i++){
+        emit({0x44, 0x0F, 0xB6, (uint8_t)(0x47 | i << 3), i});     //movzx r(8+i)d, byte [rdi+i]
+    }
+    out.insert(out.end(), body.begin(), body.end());
+    //epilogue: store the SM83 registers back and restore
+    for(uint8_t i = 0; i < NUM_REGS_8; i++){
+        emit({0x44, 0x88, (uint8_t)(0x47 | i << 3), i});           //mov byte [rdi+i], r(8+i)b
+    }
+    emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B});  //pop r15-r12, rbx
+#ifdef _WIN32
+    emit({0x5F});                                   //pop rdi
+#endif
+    emit({0xC3});                                   //ret
+
+    if(codeUsed + out.size() > JIT_CODE_SIZE){
+        //start over, entries stay where they are since the caller holds on to this one
+        for(auto& entry : runs){
+            entry.second.code = nullptr;
+            entry.second.hits = 0;
+        }
+        codeUsed = 0;
+    }
+    setWritable(true);
+    std::memcpy(codeBuf + codeUsed, out.data(), out.size());
+    setWritable(false);
+    run.code = (NativeRun)(codeBuf + codeUsed);
+    codeUsed += out.size();
+}
+
+int Jit::opLength(Regval8 opcode){
+    if(opcode == CB_OP || (opcode & 0xC7) == 0x06 || (opcode & 0xC7) == 0xC6){
+        return 2;
+    }
+    if((opcode & 0xCF) == 0x01){
+        return 3;
+    }
+    return 1;
+}
+
+void Jit::emit(std::initializer_list<uint8_t> bytes){
+    out.insert(out.end(), bytes);
+}
+
+void Jit::emitAluReg(uint8_t ext, RegIndex_8 dst, RegIndex_8 src){
+    emit({0x45, (uint8_t)(ext << 3), (uint8_t)(0xC0 | src << 3 | dst)});
+}
+
+void Jit::emitAluImm(uint8_t ext, RegIndex_8 dst, Regval8 imm){
+    emit({0x41, 0x80, (uint8_t)(0xC0 | ext << 3 | dst), imm});
+}
+
+//Loads the SM83 carry flag into the x86 one, for ADC, SBC, RL and RR
+void Jit::emitCarryIn(){
+    emit({0x41, 0x0F, 0xBA, 0xE5, 0x04});          //bt r13d, 4
+}
+
+/*
+F = (F & keep) | (table[AH] & set) | force. The low nibble of F is kept as it
+is by every op, like the interpreter does.
+*/
+void Jit::emitFlagsFromAH(Regval8 keep, Regval8 set, Regval8 force){
+    emit({0x9F});                                   //lahf
+    emit({0x0F, 0xB6, 0xD4});                       //movzx edx, ah
+    emit({0x0F, 0xB6, 0x14, 0x13});                 //movzx edx, byte [rbx+rdx]
+    emit({0x83, 0xE2, set});                        //and edx, set
+    emitFlagsFromScratch(keep, force);
+}
+
+//F = (F & keep) | edx | force
+void Jit::emitFlagsFromScratch(Regval8 keep, Regval8 force){
+    emit({0x41, 0x83, 0xE5, keep});                 //and r13d, keep
+    emit({0x41, 0x09, 0xD5});                       //or r13d, edx
+    if(force){
+        emit({0x41, 0x83, 0xCD, force});            //or r13d, force
+    }
+}
+
+bool Jit::emitOp(Regval8 opcode, const Regval8* operands){
+    int dst = regField[(opcode >> 3) & 0x07];
+    int src = regField[opcode & 0x07];
+    //LD r, r'
+    if(opcode >= LD_B_B && opcode < ADD_B){
+        if(opcode == HALT || dst == NO_REG || src == NO_REG){
+            return false;
+        }
+        if(dst != src){
+            emit({0x45, 0x88, (uint8_t)(0xC0 | src << 3 | dst)});     //mov dst, src
+        }
+        return true;
+    }
+    //ALU A, r and ALU A, imm
+    bool aluReg = opcode >= ADD_B && opcode < RET_NZ;
+    if(aluReg || (opcode & 0xC7) == ADD_IMM){
+        uint8_t op = aluOps[(opcode >> 3) & 0x07];
+        //SBC A, A works out its flags from the already changed A
+        if((aluReg && src == NO_REG) || opcode == SBC_A){
+            return false;
+        }
+        if(op == X86_ADC || op == X86_SBB){
+            emitCarryIn();
+        }
+        if(aluReg){
+            emitAluReg(op, A, (RegIndex_8)src);
+        }
+        else{
+            emitAluImm(op, A, operands[0]);
+        }
+        switch(op){
+            case X86_ADD:
+            case X86_ADC:
+                emitFlagsFromAH(0x0F, ZERO_FLAG | HALF_CARRY_FLAG | CARRY_FLAG, 0);
+                break;
+            case X86_SUB:
+            case X86_SBB:
+            case X86_CMP:
+                emitFlagsFromAH(0x0F, ZERO_FLAG | HALF_CARRY_FLAG | CARRY_FLAG, SUBTRACT_FLAG);
+                break;
+            case X86_AND:
+                emitFlagsFromAH(0x0F, ZERO_FLAG, HALF_CARRY_FLAG);
+                break;
+            default:
+                emitFlagsFromAH(0x0F, ZERO_FLAG, 0);
+                break;
+        }
+        return true;
+    }
+    //LD r, imm
+    if((opcode & 0xC7) == LD_B_IMM){
+        if(dst == NO_REG){
+            return false;
+        }
+        emit({0x41, (uint8_t)(0xB0 | dst), operands[0]});          //mov dst, imm
+        return true;
+    }
+    //INC r and DEC r, carry is left alone
+    if((opcode & 0xC7) == INC_B || (opcode & 0xC7) == DEC_B){
+        if(dst == NO_REG){
+            return false;
+        }
+        bool inc = (opcode & 0xC7) == INC_B;
+        emit({0x41, 0xFE, (uint8_t)((inc ? 0xC0 : 0xC8) | dst)});  //inc/dec dst
+        emitFlagsFromAH(CARRY_FLAG | 0x0F, ZERO_FLAG | HALF_CARRY_FLAG, inc ? 0 : SUBTRACT_FLAG);
+        return true;
+    }
+    switch(opcode){
+        case NOP:
+            return true;
+        case LD_BC_IMM:
+        case LD_DE_IMM:
+        case LD_HL_IMM:{
+            RegIndex_8 msr = opcode == LD_BC_IMM ? B : opcode == LD_DE_IMM ? D : H;
+            emit({0x41, (uint8_t)(0xB0 | (msr + 1)), operands[0]});
+            emit({0x41, (uint8_t)(0xB0 | msr), operands[1]});
+            return true;
+        }
+        case INC_BC:
+        case INC_DE:
+        case INC_HL:
+        case DEC_BC:
+        case DEC_DE:
+        case DEC_HL:{
+            bool inc = opcode == INC_BC || opcode == INC_DE || opcode == INC_HL;
+            RegIndex_8 msr = (opcode & 0x30) == 0x00 ? B : (opcode & 0x30) == 0x10 ? D : H;
+            emitAluImm(inc ? X86_ADD : X86_SUB, (RegIndex_8)(msr + 1), 1);
+            emitAluImm(inc ? X86_ADC : X86_SBB, msr, 0);
+            return true;
+        }
+        case ADD_HL_BC:
+        case ADD_HL_DE:
+        case ADD_HL_HL:{
+            RegIndex_8 msr = opcode == ADD_HL_BC ? B : opcode == ADD_HL_DE ? D : H;
+            emitAluReg(X86_ADD, L, (RegIndex_8)(msr + 1));
+            emitAluReg(X86_ADC, H, msr);
+            emitFlagsFromAH(ZERO_FLAG | 0x0F, HALF_CARRY_FLAG | CARRY_FLAG, 0);
+            return true;
+        }
+        case CPL:
+            emitAluImm(X86_XOR, A, 0xFF);
+            emit({0x41, 0x83, 0xCD, SUBTRACT_FLAG | HALF_CARRY_FLAG});     //or r13d, N|H
+            return true;
+        case SCF:
+            emit({0x41, 0x83, 0xE5, ZERO_FLAG | CARRY_FLAG | 0x0F});       //and r13d, Z|C
+            emit({0x41, 0x83, 0xCD, CARRY_FLAG});                          //or r13d, C
+            return true;
+        case CCF:
+            emit({0x41, 0x83, 0xF5, CARRY_FLAG});                          //xor r13d, C
+            emit({0x41, 0x83, 0xE5, ZERO_FLAG | CARRY_FLAG | 0x0F});       //and r13d, Z|C
+            return true;
+        case RLCA:
+        case RRCA:
+        case RLA:
+        case RRA:{
+            //same as the CB versions, except Z always ends up clear
+            uint8_t op = shiftOps[(opcode >> 3) & 0x03];
+            emit({0x31, 0xD2});                                             //xor edx, edx
+            if(op == X86_RCL || op == X86_RCR){
+                emitCarryIn();
+            }
+            emit({0x41, 0xD0, (uint8_t)(0xC0 | op << 3 | A)});             //rotate A
+            emit({0x0F, 0x92, 0xC2});                                       //setc dl
+            emit({0xC1, 0xE2, 0x04});                                       //shl edx, 4
+            emitFlagsFromScratch(0x0F, 0);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool Jit::emitCbOp(Regval8 cbOp){
+    int reg = regField[cbOp & 0x07];
+    if(reg == NO_REG){
+        return false;
+    }
+    Regval8 mask = 1 << ((cbOp >> 3) & 0x07);
+    if(cbOp >= SET_0_B){
+        emitAluImm(X86_OR, (RegIndex_8)reg, mask);
+        return true;
+    }
+    if(cbOp >= RES_0_B){
+        emitAluImm(X86_AND, (RegIndex_8)reg, ~mask);
+        return true;
+    }
+    emit({0x31, 0xD2, 0x31, 0xC9});                                         //xor edx, edx / xor ecx, ecx
+    if(cbOp >= BIT_0_B){
+        emit({0x41, 0xF6, (uint8_t)(0xC0 | reg), mask});                   //test reg, mask
+        emit({0x0F, 0x94, 0xC1});                                           //setz cl
+        emit({0xC1, 0xE1, 0x07});                                           //shl ecx, 7
+        emit({0x09, 0xCA});                                                 //or edx, ecx
+        emitFlagsFromScratch(CARRY_FLAG | 0x0F, HALF_CARRY_FLAG);
+        return true;
+    }
+    uint8_t op = shiftOps[(cbOp >> 3) & 0x07];
+    bool swap = (cbOp & 0xF8) == SWAP_B;
+    if(op == X86_RCL || op == X86_RCR){
+        emitCarryIn();
+    }
+    if(swap){
+        emit({0x41, 0xC0, (uint8_t)(0xC0 | reg), 4});                      //rol reg, 4
+    }
+    else{
+        emit({0x41, 0xD0, (uint8_t)(0xC0 | op << 3 | reg)});               //shift reg
+        emit({0x0F, 0x92, 0xC2});                                           //setc dl
+        emit({0xC1, 0xE2, 0x04});                                           //shl edx, 4
+    }
+    emit({0x45, 0x84, (uint8_t)(0xC0 | reg << 3 | reg)});                  //test reg, reg
+    emit({0x0F, 0x94, 0xC1});                                               //setz cl
+    emit({0xC1, 0xE1, 0x07});                                               //shl ecx, 7
+    emit({0x09, 0xCA});                                                     //or edx, ecx
+    emitFlagsFromScratch(0x0F, 0);
+    return true;
+}
+#endif
@@ -0,0 +1,115 @@
+#include "joypad.h"
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <stdexcept>
+
+//JOYP bits that always read as 1
+constexpr Regval8 JOYP_UNUSED_MASK = 0xC0;
+constexpr Regval8 JOYP_LINES_MASK = 0x0F;
+
+Joypad::Joypad(Bus& bus) : mem(bus), joypReg(mem.getRegister(JOYP_REG_ADDR)), interrupts(bus){
+    cycle = 0;
+    state = JOYPAD_RELEASED;
+    select = joypReg & (PAD_SELECT_MASK | BUTTON_SELECT_MASK);
+    lines = JOYP_LINES_MASK;
+    updateLines();
+    mem.onWrite(JOYP_REG_ADDR, [this](Regval8 byte){
+        select = byte & (PAD_SELECT_MASK | BUTTON_SELECT_MASK);
+        updateLines();
+    });
+}
+
+/*
+Each line of the low nibble is pulled low by a held button of either selected
+half. Only a line going low requests the interrupt, so rewriting JOYP or
+releasing a button never does.
+*/
+void Joypad::updateLines(){
+    Regval8 newLines = JOYP_LINES_MASK;
+    if(!(select & PAD_SELECT_MASK))
+        newLines &= (state & ALL_PAD_MASK) >> 4;
+    if(!(select & BUTTON_SELECT_MASK))
+        newLines &= state & ALL_BUTTON_MASK;
+    if(lines & ~newLines)
+        interrupts.raise(JOYPAD_INT);
+    lines = newLines;
+    joypReg = JOYP_UNUSED_MASK | select | lines;
+}
+
+void Joypad::applyDue(){
+    while(!events.empty() && events.front().cycle <= cycle){
+        state = events.front().state;
+        events.pop_front();
+        updateLines();
+    }
+}
+
+uint64_t Joypad::queueEvent(uint64_t cycle, Regval8 state){
+    if(!events.empty())
+        cycle = std::max(cycle, events.back().cycle);
+    events.push_back({cycle, state});
+    return cycle;
+}
+
+Regval8 Joypad::getQueuedState(){
+    return events.empty() ? state : events.back().state;
+}
+
+void Joypad::emulateCycle(){
+    applyDue();
+    cycle++;
+}
+
+void Joypad::emulateCycles(int n){
+    while(n > 0){
+        if(events.empty()){
+            cycle += n;
+            return;
+        }
+        int skip = std::min(n, cyclesUntilEvent());
+        cycle += skip;
+        n -= skip;
+        if(n > 0){
+            emulateCycle();
+            n--;
+        }
+    }
+}
+
+int Joypad::cyclesUntilEvent(){
+    if(events.empty())
+        return NO_EVENT;
+    if(events.front().cycle <= cycle)
+        return 0;
+    return std::min<uint64_t>(events.front().cycle - cycle, INT_MAX);
+}
+
+std::vector<JoypadEvent> Joypad::loadInputLog(std::string file){
+    std::vector<JoypadEvent> log;
+    std::ifstream in(file);
+    if(!in.is_open()){
+        throw std::invalid_argument("Joypad::loadInputLog(): Failed to open requested input log.");
+    }
+    uint64_t cycle;
+    unsigned int state;
+    while(in >> cycle >> std::hex >> state >> std::dec){
+        if(state > 0xFF){
+            break;
+        }
+        log.push_back({cycle, (Regval8)state});
+    }
+    //reading only stops short of the end on a line that isn't a "cycle state" pair
+    if(!in.eof()){
+        throw std::invalid_argument("Joypad::loadInputLog(): Malformed input log.");
+    }
+    return log;
+}
+
+bool Joypad::saveInputLog(std::string file, const std::vector<JoypadEvent>& log){
+    std::ofstream out(file);
+    for(const JoypadEvent& event : log){
+        out << event.cycle << " " << std::hex << (int)event.state << std::dec << "\n";
+    }
+    return !out.fail();
+}
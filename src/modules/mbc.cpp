@@ -0,0 +1,413 @@
+#include "mbc.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <ctime>
+
+constexpr Regval16 MBC5_ROM_BANK_HIGH_START = 0x3000;
+constexpr Regval8 RAM_ENABLE_VALUE = 0x0A;
+constexpr Regval8 MBC2_ROM_SELECT_BIT = 0x01;       //bit 8 of the address
+constexpr Regval8 RTC_SECONDS = 0x08;
+constexpr Regval8 RTC_DAY_HIGH = 0x0C;
+
+//Indices into the RTC registers
+constexpr int RTC_S = 0;
+constexpr int RTC_M = 1;
+constexpr int RTC_H = 2;
+constexpr int RTC_DL = 3;
+constexpr int RTC_DH = 4;
+constexpr Regval8 DAY_HIGH_BIT = 0x01;
+constexpr Regval8 HALT_BIT = 0x40;
+constexpr Regval8 DAY_CARRY_BIT = 0x80;
+constexpr Regval8 RTC_REG_MASKS[NUM_RTC_REGS] = {0x3F, 0x3F, 0x1F, 0xFF, 0xC1};
+constexpr uint64_t RTC_NUM_DAYS = 512;
+constexpr size_t RTC_TIMESTAMP_OFFSET = 2 * NUM_RTC_REGS * 4;
+
+//MBC1M boards are always 1 MiB, with a copy of the header at the start of each game
+constexpr int MBC1M_NUM_ROM_BANKS = 64;
+constexpr int MBC1M_SECOND_GAME_BANK = 0x10;
+constexpr Regval16 LOGO_START = 0x0104;
+constexpr int LOGO_SIZE = 48;
+
+Mbc::Mbc(Bus& bus) : bus(bus){
+    ramEnabled = false;
+    romBank0 = 0;
+    romBankN = 1;
+    ramBank = 0;
+}
+
+Mbc::~Mbc(){
+}
+
+std::unique_ptr<Mbc> Mbc::create(Bus& bus, Regval8 type){
+    std::unique_ptr<Mbc> mbc;
+    switch(type){
+        case ROM_ONLY:
+        case ROM_RAM:
+        case ROM_RAM_BATTERY:
+            mbc.reset(new RomOnlyMbc(bus));
+            break;
+        case MBC1:
+        case MBC1_RAM:
+        case MBC1_RAM_BATTERY:
+            mbc.reset(new Mbc1(bus));
+            break;
+        case MBC2:
+        case MBC2_BATTERY:
+            mbc.reset(new Mbc2(bus));
+            break;
+        case MBC3_TIMER_BATTERY:
+        case MBC3_TIMER_RAM_BATTERY:
+            mbc.reset(new Mbc3(bus, true));
+            break;
+        case MBC3:
+        case MBC3_RAM:
+        case MBC3_RAM_BATTERY:
+            mbc.reset(new Mbc3(bus, false));
+            break;
+        case MBC5:
+        case MBC5_RAM:
+        case MBC5_RAM_BATTERY:
+            mbc.reset(new Mbc5(bus, false));
+            break;
+        case MBC5_RUMBLE:
+        case MBC5_RUMBLE_RAM:
+        case MBC5_RUMBLE_RAM_BATTERY:
+            mbc.reset(new Mbc5(bus, true));
+            break;
+        default:
+            throw std::logic_error("Mbc::create(): Cartridge type not yet supported.");
+    }
+    //ramIsPlain() is virtual, so the first remap can't happen in the base constructor
+    mbc->remap();
+    return mbc;
+}
+
+/*
+Bank numbers wrap around the number of banks the cartridge actually has, the
+same way the unused upper bank lines are left unconnected on real boards.
+*/
+void Mbc::remap(){
+    int numBanks = bus.romBanks.size();
+    bus.romBank0 = romBank0 % numBanks;
+    bus.currRomBank = romBankN % numBanks;
+    bus.currRamBank = ramBank;
+    bus.ramMapped = ramEnabled && !bus.cartRam->empty() && ramIsPlain();
+    bus.mapBanks();
+}
+
+bool Mbc::ramIsPlain() const{
+    return true;
+}
+
+size_t Mbc::ramOffset(Regval16 addr) const{
+    return ((size_t)ramBank * RAM_BANK_BANK_SIZE + addr - RAM_BANK_START) % bus.cartRam->getSize();
+}
+
+Regval8 Mbc::readRam(Regval16 addr){
+    if(!ramEnabled || bus.cartRam->empty())
+        return 0xFF;
+    return (*bus.cartRam)[ramOffset(addr)];
+}
+
+void Mbc::writeRam(Regval16 addr, Regval8 byte){
+    if(!ramEnabled || bus.cartRam->empty())
+        return;
+    bus.writeCartRam(ramOffset(addr), byte);
+}
+
+size_t Mbc::getTrailerSize() const{
+    return 0;
+}
+
+void Mbc::loadTrailer(const Regval8* trailer, size_t size){
+}
+
+void Mbc::saveTrailer(Regval8* trailer){
+}
+
+bool Mbc::trailerChanged() const{
+    return false;
+}
+
+RomOnlyMbc::RomOnlyMbc(Bus& bus) : Mbc(bus){
+    ramEnabled = true;
+}
+
+void RomOnlyMbc::writeRegister(Regval16 addr, Regval8 byte){
+}
+
+Mbc1::Mbc1(Bus& bus) : Mbc(bus){
+    bank1 = 1;
+    bank2 = 0;
+    mode = SIMPLE;
+    multicart = false;
+    if(bus.romBanks.size() == MBC1M_NUM_ROM_BANKS){
+        const Regval8* logo = bus.getRomBank(0) + LOGO_START;
+        const Regval8* secondLogo = bus.getRomBank(MBC1M_SECOND_GAME_BANK) + LOGO_START;
+        //an empty logo doesn't count, blank banks would match each other
+        multicart = std::memcmp(logo, secondLogo, LOGO_SIZE) == 0 &&
+            std::any_of(logo, logo + LOGO_SIZE, [](Regval8 byte){return byte != 0;});
+    }
+    updateBanks();
+}
+
+void Mbc1::updateBanks(){
+    int shift = multicart ? 4 : 5;
+    int low = multicart ? bank1 & 0x0F : bank1;
+    romBank0 = mode == ADVANCED ? bank2 << shift : 0;
+    romBankN = bank2 << shift | low;
+    ramBank = mode == ADVANCED ? bank2 : 0;
+}
+
+void Mbc1::writeRegister(Regval16 addr, Regval8 byte){
+    if(addr <= RAM_BANK_ENABLE_END){
+        ramEnabled = (byte & 0x0F) == RAM_ENABLE_VALUE;
+    }
+    else if(addr <= ROM_BANK_SELECT_END){
+        //bank 0 can't be selected, but only a zero in all five bits counts as 0
+        bank1 = byte & 0x1F;
+        if(bank1 == 0)
+            bank1 = 1;
+    }
+    else if(addr <= RAM_BANK_SELECT_END){
+        bank2 = byte & 0x03;
+    }
+    else{
+        mode = (byte & 0x01) ? ADVANCED : SIMPLE;
+    }
+    updateBanks();
+    remap();
+}
+
+Mbc2::Mbc2(Bus& bus) : Mbc(bus){
+    //the RAM is inside the controller, the header says the cart has none
+    bus.cartRam.reset(new CartRam(MBC2_RAM_SIZE));
+}
+
+bool Mbc2::ramIsPlain() const{
+    return false;
+}
+
+void Mbc2::writeRegister(Regval16 addr, Regval8 byte){
+    if(addr > ROM_BANK_SELECT_END)
+        return;
+    if((addr >> 8) & MBC2_ROM_SELECT_BIT){
+        romBankN = byte & 0x0F;
+        if(romBankN == 0)
+            romBankN = 1;
+    }
+    else{
+        ramEnabled = (byte & 0x0F) == RAM_ENABLE_VALUE;
+    }
+    remap();
+}
+
+//Only the low nibble exists, the upper one reads back as set
+Regval8 Mbc2::readRam(Regval16 addr){
+    if(!ramEnabled)
+        return 0xFF;
+    return 0xF0 | (*bus.cartRam)[(addr - RAM_BANK_START) % MBC2_RAM_SIZE];
+}
+
+void Mbc2::writeRam(Regval16 addr, Regval8 byte){
+    if(!ramEnabled)
+        return;
+    bus.writeCartRam((addr - RAM_BANK_START) % MBC2_RAM_SIZE, byte & 0x0F);
+}
+
+Mbc3::Mbc3(Bus& bus, bool timer) : Mbc(bus), timer(timer){
+    ramSelect = 0;
+    lastLatchWrite = 0xFF;
+    rtcRegs.fill(0);
+    rtcLatched.fill(0);
+    rtcCycle = currentCycle();
+    rtcWritten = false;
+    savedCycle = rtcCycle;
+    savedTime = std::time(nullptr);
+}
+
+bool Mbc3::rtcSelected() const{
+    return timer && ramSelect >= RTC_SECONDS && ramSelect <= RTC_DAY_HIGH;
+}
+
+bool Mbc3::ramIsPlain() const{
+    return ramSelect <= 0x03;
+}
+
+uint64_t Mbc3::currentCycle() const{
+    return bus.cycleCount ? bus.cycleCount() : 0;
+}
+
+/*
+Counters holding a value out of their range, which only a write can leave
+them with, run on up to the top of their bits and wrap to 0 without a carry.
+Returns the number of carries into the next counter.
+*/
+static uint64_t tickRtcCounter(Regval8& counter, uint64_t ticks, uint64_t period, Regval8 mask){
+    if(counter >= period){
+        uint64_t toWrap = mask + 1 - counter;
+        if(ticks < toWrap){
+            counter += ticks;
+            return 0;
+        }
+        ticks -= toWrap;
+        counter = 0;
+    }
+    uint64_t total = counter + ticks;
+    counter = total % period;
+    return total / period;
+}
+
+void Mbc3::advanceRtc(uint64_t seconds){
+    uint64_t carries = tickRtcCounter(rtcRegs[RTC_S], seconds, 60, RTC_REG_MASKS[RTC_S]);
+    carries = tickRtcCounter(rtcRegs[RTC_M], carries, 60, RTC_REG_MASKS[RTC_M]);
+    carries = tickRtcCounter(rtcRegs[RTC_H], carries, 24, RTC_REG_MASKS[RTC_H]);
+    uint64_t days = ((uint64_t)(rtcRegs[RTC_DH] & DAY_HIGH_BIT) << 8 | rtcRegs[RTC_DL]) + carries;
+    //the carry stays set until the game clears it
+    if(days >= RTC_NUM_DAYS)
+        rtcRegs[RTC_DH] |= DAY_CARRY_BIT;
+    days %= RTC_NUM_DAYS;
+    rtcRegs[RTC_DL] = days & 0xFF;
+    rtcRegs[RTC_DH] = (rtcRegs[RTC_DH] & ~DAY_HIGH_BIT) | days >> 8;
+}
+
+//Whole seconds are applied, the part of a second left over stays pending
+void Mbc3::updateRtc(){
+    uint64_t now = currentCycle();
+    if((rtcRegs[RTC_DH] & HALT_BIT) || now < rtcCycle){
+        rtcCycle = now;
+        return;
+    }
+    uint64_t seconds = (now - rtcCycle) / RTC_CYCLES_PER_SECOND;
+    rtcCycle += seconds * RTC_CYCLES_PER_SECOND;
+    advanceRtc(seconds);
+}
+
+void Mbc3::writeRegister(Regval16 addr, Regval8 byte){
+    if(addr <= RAM_BANK_ENABLE_END){
+        ramEnabled = (byte & 0x0F) == RAM_ENABLE_VALUE;
+    }
+    else if(addr <= ROM_BANK_SELECT_END){
+        romBankN = byte & 0x7F;
+        if(romBankN == 0)
+            romBankN = 1;
+    }
+    else if(addr <= RAM_BANK_SELECT_END){
+        ramSelect = byte;
+        if(ramIsPlain())
+            ramBank = byte;
+    }
+    else{
+        //writing 0 then 1 copies the running clock into the registers seen by reads
+        if(timer && lastLatchWrite == 0x00 && byte == 0x01){
+            updateRtc();
+            rtcLatched = rtcRegs;
+        }
+        lastLatchWrite = byte;
+    }
+    remap();
+}
+
+Regval8 Mbc3::readRam(Regval16 addr){
+    if(ramIsPlain())
+        return Mbc::readRam(addr);
+    if(!ramEnabled || !rtcSelected())
+        return 0xFF;
+    return rtcLatched[ramSelect - RTC_SECONDS];
+}
+
+void Mbc3::writeRam(Regval16 addr, Regval8 byte){
+    if(ramIsPlain()){
+        Mbc::writeRam(addr, byte);
+    }
+    else if(ramEnabled && rtcSelected()){
+        int reg = ramSelect - RTC_SECONDS;
+        updateRtc();
+        rtcRegs[reg] = byte & RTC_REG_MASKS[reg];
+        //writing the seconds restarts the second in progress
+        if(reg == RTC_S)
+            rtcCycle = currentCycle();
+        rtcWritten = true;
+    }
+}
+
+size_t Mbc3::getTrailerSize() const{
+    return timer ? RTC_TRAILER_SIZE : 0;
+}
+
+/*
+The registers were saved along with the host time, the time that has passed
+on the host since then is added on. A save without a timestamp leaves the
+clock where it was.
+*/
+void Mbc3::loadTrailer(const Regval8* trailer, size_t size){
+    if(!timer || size < RTC_OLD_TRAILER_SIZE){
+        return;
+    }
+    for(int i = 0; i < NUM_RTC_REGS; i++){
+        rtcRegs[i] = trailer[i * 4] & RTC_REG_MASKS[i];
+        rtcLatched[i] = trailer[(NUM_RTC_REGS + i) * 4] & RTC_REG_MASKS[i];
+    }
+    size_t timestampSize = size >= RTC_TRAILER_SIZE ? 8 : 4;
+    uint64_t savedAt = 0;
+    for(size_t i = 0; i < timestampSize; i++){
+        savedAt |= (uint64_t)trailer[RTC_TIMESTAMP_OFFSET + i] << (8 * i);
+    }
+    rtcCycle = currentCycle();
+    uint64_t now = std::time(nullptr);
+    if(savedAt && now > savedAt && !(rtcRegs[RTC_DH] & HALT_BIT))
+        advanceRtc(now - savedAt);
+}
+
+void Mbc3::saveTrailer(Regval8* trailer){
+    if(!timer){
+        return;
+    }
+    updateRtc();
+    std::fill(trailer, trailer + RTC_TRAILER_SIZE, 0);
+    for(int i = 0; i < NUM_RTC_REGS; i++){
+        trailer[i * 4] = rtcRegs[i];
+        trailer[(NUM_RTC_REGS + i) * 4] = rtcLatched[i];
+    }
+    uint64_t now = std::time(nullptr);
+    for(size_t i = 0; i < 8; i++){
+        trailer[RTC_TIMESTAMP_OFFSET + i] = (now >> (8 * i)) & 0xFF;
+    }
+    rtcWritten = false;
+    savedCycle = currentCycle();
+    savedTime = now;
+}
+
+/*
+Loading adds host time to the saved clock, which only comes out right as long
+as emulated time has kept pace with it. Fast-forward or a slow host put the two
+apart, and so call for a new save.
+*/
+bool Mbc3::trailerChanged() const{
+    if(rtcWritten){
+        return true;
+    }
+    int64_t emulated = (currentCycle() - savedCycle) / RTC_CYCLES_PER_SECOND;
+    int64_t host = (int64_t)std::time(nullptr) - (int64_t)savedTime;
+    return emulated - host > 1 || host - emulated > 1;
+}
+
+Mbc5::Mbc5(Bus& bus, bool rumble) : Mbc(bus), rumble(rumble){
+}
+
+void Mbc5::writeRegister(Regval16 addr, Regval8 byte){
+    if(addr <= RAM_BANK_ENABLE_END){
+        ramEnabled = (byte & 0x0F) == RAM_ENABLE_VALUE;
+    }
+    else if(addr < MBC5_ROM_BANK_HIGH_START){
+        romBankN = (romBankN & 0x100) | byte;
+    }
+    else if(addr <= ROM_BANK_SELECT_END){
+        romBankN = (romBankN & 0xFF) | (byte & 0x01) << 8;
+    }
+    else if(addr <= RAM_BANK_SELECT_END){
+        ramBank = byte & (rumble ? 0x07 : 0x0F);
+    }
+    remap();
+}
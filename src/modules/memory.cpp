@@ -1,39 +1,138 @@
 #include "memory.h"
+#include "mbc.h"
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
 
-//static vars
-std::array<Regval8,UINT16_MAX+1> Memory::mem;
-std::array<std::array<Regval8, RAM_BANK_BANK_SIZE>, MBC1_NUM_RAM_BANKS> Memory::ramBanks;
-std::array<std::array<Regval8, ROM_BANK_SIZE>, MBC1_NUM_ROM_BANKS> Memory::romBanks;
-Regval8 Memory::currRamBank;
-Regval8 Memory::currRomBank;
-Regval8 Memory::joypadBuff;
-CartType Memory::cartType;
-BankingMode Memory::mode;
-bool Memory::ramEnabled = false;
+constexpr Regval16 CARTRIDGE_TYPE_BYTE_ADDR= 0x0147;
 
-constexpr Regval8 PAD_READ_MASK = 0x10; 
-constexpr Regval8 BUTTON_READ_MASK = 0x20;
+//Stands in for banks the cartridge doesn't have
+static const std::array<Regval8, ROM_BANK_SIZE> EMPTY_ROM_BANK = {};
 
-constexpr Regval16 CARTRIDGE_TYPE_BYTE_ADDR= 0x0147;
+//Bytes of cartridge RAM for each RAM size code of the header
+static size_t cartRamSize(Regval8 code){
+    switch(code){
+        case 0x01:
+            return 2 * 1024;
+        case 0x02:
+            return RAM_BANK_BANK_SIZE;
+        case 0x03:
+            return 4 * RAM_BANK_BANK_SIZE;
+        case 0x04:
+            return 16 * RAM_BANK_BANK_SIZE;
+        case 0x05:
+            return 8 * RAM_BANK_BANK_SIZE;
+        default:
+            return 0;
+    }
+}
 
-Memory::Memory(Permission perm) : perm(perm){
+Bus::Bus(){
+    mem.fill(0);
+    //until a game is loaded the bus acts as a cartridge with no MBC and one RAM bank
+    cartRam.reset(new CartRam(RAM_BANK_BANK_SIZE));
+    romBanks.assign(2, EMPTY_ROM_BANK.data());
     mem[JOYP_REG_ADDR] = 0xCF;
-    joypadBuff = 0xFF;
-    currRamBank = 0;
+    romBank0 = 0;
     currRomBank = 1;
+    currRamBank = 0;
+    ramMapped = false;
+    cartType = ROM_ONLY;
+    signalFlags = 0;
+    signalEnable = 0;
+    cpuLocks = 0;
+    pendingInts = 0;
+    codePages.fill(false);
+    codeWritten = false;
+    mapPages();
+    mbc = Mbc::create(*this, ROM_ONLY);
+}
+
+//Out of line, Mbc is incomplete in the header
+Bus::~Bus(){
+}
+
+/*
+Only pages whose accesses are plain loads and stores get an entry. VRAM, OAM
+and I/O stay on the slow path for the peripheral catch-up hook, writes to the
+bottom half of the map for the MBC registers and echo RAM for its permission
+check.
+*/
+void Bus::mapPages(){
+    readPages.fill(nullptr);
+    writePages.fill(nullptr);
+    for(int page = WRAM_START / MEM_PAGE_SIZE; page <= WRAM_END / MEM_PAGE_SIZE; page++){
+        readPages[page] = &mem[page * MEM_PAGE_SIZE];
+        writePages[page] = &mem[page * MEM_PAGE_SIZE];
+        for(int i = 0; i < MEM_PAGE_SIZE / CODE_PAGE_SIZE; i++){
+            if(codePages[page * (MEM_PAGE_SIZE / CODE_PAGE_SIZE) + i]){
+                writePages[page] = nullptr;
+            }
+        }
+    }
+    for(int page = ECHO_START / MEM_PAGE_SIZE; page <= ECHO_END / MEM_PAGE_SIZE; page++){
+        readPages[page] = &mem[page * MEM_PAGE_SIZE];
+    }
+    mapBanks();
+}
+
+void Bus::mapBanks(){
+    for(int page = ROM_BANK_0_START / MEM_PAGE_SIZE; page <= ROM_BANK_0_END / MEM_PAGE_SIZE; page++){
+        readPages[page] = getRomBank(romBank0) + page * MEM_PAGE_SIZE;
+    }
+    for(int page = ROM_BANK_N_START / MEM_PAGE_SIZE; page <= ROM_BANK_N_END / MEM_PAGE_SIZE; page++){
+        readPages[page] = getRomBank(currRomBank) + page * MEM_PAGE_SIZE - ROM_BANK_N_START;
+    }
+    for(int page = RAM_BANK_START / MEM_PAGE_SIZE; page <= RAM_BANK_END / MEM_PAGE_SIZE; page++){
+        readPages[page] = nullptr;
+        writePages[page] = nullptr;
+        if(ramMapped){
+            //banks past the end of the RAM mirror the ones it has
+            size_t offset = ((size_t)currRamBank * RAM_BANK_BANK_SIZE + page * MEM_PAGE_SIZE - RAM_BANK_START) % cartRam->getSize();
+            readPages[page] = &(*cartRam)[offset];
+            //pages of a save file stay on the slow path until written, to be marked dirty
+            if(cartRam->isWritable(offset))
+                writePages[page] = &(*cartRam)[offset];
+        }
+    }
+}
+
+void Bus::writeCartRam(size_t offset, Regval8 byte){
+    (*cartRam)[offset] = byte;
+    if(cartRam->markDirty(offset) && ramMapped)
+        mapBanks();
+}
+
+void Bus::unmapCodePage(Regval16 addr){
+    writePages[addr / MEM_PAGE_SIZE] = nullptr;
 }
 
-bool Memory::inRange(Regval16 addr, Regval16 low, Regval16 hi) const{
+const Regval8* Bus::getRomBank(int bank) const{
+    return (size_t)bank < romBanks.size() ? romBanks[bank] : EMPTY_ROM_BANK.data();
+}
+
+void Bus::clearCodePages(){
+    codePages.fill(false);
+    codeWritten = false;
+    for(int page = WRAM_START / MEM_PAGE_SIZE; page <= WRAM_END / MEM_PAGE_SIZE; page++){
+        writePages[page] = &mem[page * MEM_PAGE_SIZE];
+    }
+}
+
+template<Permission perm>
+Memory<perm>::Memory(Bus& bus) : bus(bus){
+}
+
+template<Permission perm>
+bool Memory<perm>::inRange(Regval16 addr, Regval16 low, Regval16 hi) const{
     if(addr >= low && addr <= hi)
         return true;
     return false;
 }
 
-bool Memory::checkPerm(const Regval16 addr, const Access acc) const{
+template<Permission perm>
+bool Memory<perm>::checkPerm(const Regval16 addr, const Access acc) const{
     if((inRange(addr, ECHO_START, ECHO_END) ||
         inRange(addr, BAD_ZONE_START, BAD_ZONE_END))){
         return false;
@@ -41,152 +140,244 @@ bool Memory::checkPerm(const Regval16 addr, const Access acc) const{
     return true;
 }
 
-void Memory::saveRamState(std::string file){
+template<Permission perm>
+bool Memory<perm>::lockedOut(const Regval16 addr) const{
+    if((bus.cpuLocks & DMA_LOCK) && addr < IO_START)
+        return true;
+    if((bus.cpuLocks & VRAM_LOCK) && inRange(addr, VRAM_START, VRAM_END))
+        return true;
+    return (bus.cpuLocks & OAM_LOCK) && inRange(addr, OAM_START, OAM_END);
+}
+
+template<Permission perm>
+bool Memory<perm>::lockMemoryDMA(){
+    if constexpr(perm != DMA_PERM)
+        return false;
+    bus.cpuLocks |= DMA_LOCK;
+    return true;
+}
+
+template<Permission perm>
+bool Memory<perm>::unlockMemoryDMA(){
+    if constexpr(perm != DMA_PERM)
+        return false;
+    bus.cpuLocks &= ~DMA_LOCK;
+    return true;
+}
+
+template<Permission perm>
+bool Memory<perm>::lockVram(){
+    if constexpr(perm != PPU_PERM)
+        return false;
+    bus.cpuLocks |= VRAM_LOCK;
+    return true;
+}
+
+template<Permission perm>
+bool Memory<perm>::unlockVram(){
+    if constexpr(perm != PPU_PERM)
+        return false;
+    bus.cpuLocks &= ~VRAM_LOCK;
+    return true;
+}
+
+template<Permission perm>
+bool Memory<perm>::lockOam(){
+    if constexpr(perm != PPU_PERM)
+        return false;
+    bus.cpuLocks |= OAM_LOCK;
+    return true;
+}
+
+template<Permission perm>
+bool Memory<perm>::unlockOam(){
+    if constexpr(perm != PPU_PERM)
+        return false;
+    bus.cpuLocks &= ~OAM_LOCK;
+    return true;
+}
+
+template<Permission perm>
+void Memory<perm>::saveRamState(std::string file){
     std::ofstream outFile(file, std::ios_base::out | std::ios_base::binary);
-    int bankBytesWritten = 0;
-    int bankNum = 0;
-    while(bankNum < MBC1_NUM_RAM_BANKS){
-        while(bankBytesWritten < RAM_BANK_BANK_SIZE){
-            outFile.write((char*)ramBanks[bankNum].data(), RAM_BANK_BANK_SIZE);
-            long currBytesWritten = outFile.tellp(); 
-            bankBytesWritten += currBytesWritten - bankBytesWritten;
-        }
-        bankBytesWritten = 0;
-        bankNum++;
+    outFile.write((char*)bus.cartRam->data(), bus.cartRam->getSize());
+    std::vector<Regval8> trailer(bus.mbc->getTrailerSize());
+    bus.mbc->saveTrailer(trailer.data());
+    outFile.write((char*)trailer.data(), trailer.size());
+}
+
+template<Permission perm>
+bool Memory<perm>::loadRamState(std::string file){
+    std::ifstream inFile(file, std::ios_base::in | std::ios_base::binary);
+    if(!inFile.is_open()){
+        return false;
     }
+    inFile.read((char*)bus.cartRam->data(), bus.cartRam->getSize());
+    std::vector<Regval8> trailer(bus.mbc->getTrailerSize());
+    inFile.read((char*)trailer.data(), trailer.size());
+    bus.mbc->loadTrailer(trailer.data(), inFile.gcount());
+    return true;
 }
 
-void Memory::prepJoypadRead(const Regval8 byte) const{
-    if(!(byte & (BUTTON_READ_MASK | PAD_READ_MASK))){
-        return;
+template<Permission perm>
+bool Memory<perm>::mapRamState(std::string file){
+    size_t trailerSize = bus.mbc->getTrailerSize();
+    if(bus.cartRam->empty() && !trailerSize){
+        return false;
     }
-    if(byte & ~PAD_READ_MASK){
-        mem[JOYP_REG_ADDR] = (joypadBuff & ALL_PAD_MASK);
-        mem[JOYP_REG_ADDR] >>= 4;
+    std::unique_ptr<CartRam> mapped(new CartRam(bus.cartRam->getSize(), file, trailerSize));
+    if(!mapped->isMapped()){
+        return false;
     }
-    if(byte & ~BUTTON_READ_MASK){
-        mem[JOYP_REG_ADDR] = joypadBuff & ALL_BUTTON_MASK;
+    bus.cartRam = std::move(mapped);
+    if(trailerSize){
+        bus.mbc->loadTrailer(bus.cartRam->getTrailer(), bus.cartRam->getSavedTrailerSize());
     }
-    mem[IF_REG_ADDR] = mem[IF_REG_ADDR] | JOYPAD_INT;
+    bus.mapBanks();
+    return true;
 }
 
-void Memory::setJoypadBuff(Regval8 byte){
-    joypadBuff = byte;
+template<Permission perm>
+void Memory<perm>::saveTrailer(){
+    Regval8* trailer = bus.cartRam->getTrailer();
+    if(trailer){
+        bus.mbc->saveTrailer(trailer);
+        bus.cartRam->markDirty(bus.cartRam->getSize());
+    }
 }
 
-Regval8 Memory::getJoypadBuff(){
-    return joypadBuff;
+template<Permission perm>
+void Memory<perm>::flushRamState(){
+    if(bus.mbc->trailerChanged()){
+        saveTrailer();
+    }
+    if(bus.cartRam->handOff()){
+        bus.mapBanks();
+    }
 }
 
-bool Memory::write(const Regval16 addr, const Regval8 byte) const{
-    if(!checkPerm(addr, WRITE))
+template<Permission perm>
+bool Memory<perm>::syncRamState(){
+    if(!bus.cartRam->isMapped()){
         return false;
-    if(addr == JOYP_REG_ADDR)
-        prepJoypadRead(byte);
-    else if(inRange(addr, RAM_BANK_ENABLE_START, RAM_BANK_ENABLE_END)){
-        ramEnabled = (byte & 0x0A) == 0x0A ? mode = ADVANCED : mode = SIMPLE;
-    }
-    else if(inRange(addr, RAM_BANK_SELECT_START, RAM_BANK_SELECT_END)){
-        currRamBank = byte & 0x03;
-    }
-    else if(inRange(addr, ROM_BANK_SELECT_START, ROM_BANK_SELECT_END)){
-        switch(cartType){
-            case ROM_ONLY:
-            case MBC1:
-            case MBC1_RAM:
-            case MBC1_RAM_BATTERY:
-                currRomBank = byte & 0x1F;
-            case MBC3_TIMER_BATTERY:
-            case MBC3_TIMER_RAM_BATTERY:
-            case MBC3:
-            case MBC3_RAM:
-            case MBC3_RAM_BATTERY:
-                currRomBank = byte & 0x7F;
-                break;
-            default:
-                break;
-        }
-        if(currRomBank == 0){currRomBank = 1;}
     }
-    else if(inRange(addr, RAM_BANK_START, RAM_BANK_END) && ramEnabled){
-        ramBanks[currRamBank][addr - RAM_BANK_START] = byte;
+    saveTrailer();
+    bus.cartRam->sync();
+    return true;
+}
+
+template<Permission perm>
+void Memory<perm>::syncPeripherals(const Regval16 addr, Access acc) const{
+    if(inRange(addr, VRAM_START, VRAM_END) || inRange(addr, OAM_START, IO_END))
+        bus.syncPeripherals(addr, acc);
+}
+
+template<Permission perm>
+bool Memory<perm>::writeSlow(const Regval16 addr, const Regval8 byte) const{
+    if(!checkPerm(addr, WRITE))
+        return false;
+    if(bus.syncPeripherals)
+        syncPeripherals(addr, WRITE);
+    //VRAM and OAM locks follow the PPU mode, so they're only current after the catch-up
+    if constexpr(perm == CPU_PERM){
+        if(bus.cpuLocks && lockedOut(addr))
+            return false;
     }
+    if(addr <= ROM_BANK_N_END)
+        bus.mbc->writeRegister(addr, byte);
+    else if(inRange(addr, RAM_BANK_START, RAM_BANK_END))
+        bus.mbc->writeRam(addr, byte);
     else{
-        mem[addr] = byte;
+        bus.mem[addr] = byte;
+        if(bus.codePages[addr / CODE_PAGE_SIZE])
+            bus.codeWritten = true;
     }
+    if(addr >= IO_START && bus.ioWriteHooks[addr - IO_START])
+        bus.ioWriteHooks[addr - IO_START](byte);
     return true;
 }
 
-Regval8 Memory::read(const Regval16 addr) const{
-    /*
-    if(inRange(addr, ROM_BANK_0_START, ROM_BANK_0_END)){
-        return romBanks[currRomBank][addr - ROM_BANK_N_START];
+template<Permission perm>
+Regval8 Memory<perm>::readSlow(const Regval16 addr) const{
+    //the DMA reads its source without catching anything up
+    if constexpr(perm != DMA_PERM){
+        if(bus.syncPeripherals)
+            syncPeripherals(addr, READ);
     }
-    */
-    if(inRange(addr, ROM_BANK_N_START, ROM_BANK_N_END)){
-        return romBanks[currRomBank][addr - ROM_BANK_N_START];
+    if constexpr(perm == CPU_PERM){
+        if(bus.cpuLocks && lockedOut(addr))
+            return LOCKED_READ;
     }
-    else if(inRange(addr, RAM_BANK_START, RAM_BANK_END)){
-        if(mode != ADVANCED && currRamBank > 0){
-            throw std::logic_error("Memory::read(): Attempted access to ram bank other than bank 0 in simple mode.");
-        }
-        return ramBanks[currRamBank][addr - RAM_BANK_START];
+    //ROM is always mapped, so only unmapped cart RAM makes it down here
+    if(inRange(addr, RAM_BANK_START, RAM_BANK_END)){
+        return bus.mbc->readRam(addr);
     }
-    return mem[addr];
+    return bus.mem[addr];
 }
 
-Regval16 Memory::dump(const Regval16 addr, const Regval8* buf, const size_t n) const{
+template<Permission perm>
+Regval16 Memory<perm>::dump(const Regval16 addr, const Regval8* buf, const size_t n) const{
     size_t bytes_written = 0;
     while(bytes_written < n){
-        mem[addr + bytes_written] = buf[bytes_written];
+        bus.mem[addr + bytes_written] = buf[bytes_written];
         bytes_written++;
     }
     return bytes_written;
 }
 
-Regval16 Memory::copyRomBank(const Regval8* buf, const int bankNum){
-    size_t bytes_written = 0;
-    while(bytes_written < ROM_BANK_SIZE){
-        romBanks[bankNum][bytes_written] = buf[bytes_written];
-        bytes_written++;
+template<Permission perm>
+void Memory<perm>::mapRom(std::shared_ptr<const RomImage> rom){
+    bus.romBanks.assign(rom->getNumBanks(), EMPTY_ROM_BANK.data());
+    for(int bank = 0; bank < rom->getNumBanks(); bank++){
+        if(rom->getBank(bank))
+            bus.romBanks[bank] = rom->getBank(bank);
     }
-    return bytes_written;
+    bus.rom = rom;
+    bus.romBank0 = 0;
+    bus.currRomBank = 1;
+    bus.mapPages();
 }
 
-Regval16 Memory::copyRamBank(const Regval8* buf, const int bankNum){
-    size_t bytes_written = 0;
-    while(bytes_written < RAM_BANK_BANK_SIZE){
-        ramBanks[bankNum][bytes_written] = buf[bytes_written];
-        bytes_written++;
-    }
-    return bytes_written;
+template<Permission perm>
+Register Memory<perm>::getRegister(Regval16 addr){
+    return bus.mem[addr];
 }
 
-Register Memory::getRegister(Regval16 addr){
-    return mem[addr];
-}
-
-void Memory::resolveCartridgeType(){
-    switch(mem[CARTRIDGE_TYPE_BYTE_ADDR]){
-        case ROM_ONLY:
-        case MBC1:
-        case MBC1_RAM:
-        case MBC1_RAM_BATTERY:
-            cartType = MBC1;
-            break;
-        case MBC3_TIMER_BATTERY:
-        case MBC3_TIMER_RAM_BATTERY:
-        case MBC3:
-        case MBC3_RAM:
-        case MBC3_RAM_BATTERY:
-            cartType = MBC3;
-            break;
-        default:
-            throw std::logic_error("Memory::resolveCartridgeType(): Cartridge type not yet supported.");
+template<Permission perm>
+void Memory<perm>::onWrite(Regval16 addr, IoWriteHook hook){
+    if(!inRange(addr, IO_START, IO_END) && addr != IE_REG_ADDR){
+        throw std::logic_error("Memory::onWrite(): Write hooks are only supported on I/O registers and IE.");
+    }
+    IoWriteHook& slot = bus.ioWriteHooks[addr - IO_START];
+    if(slot){
+        slot = [first = slot, second = hook](Regval8 byte){
+            first(byte);
+            second(byte);
+        };
     }
+    else{
+        slot = hook;
+    }
+}
+
+template<Permission perm>
+void Memory<perm>::resolveCartridgeType(){
+    const Regval8* header = bus.getRomBank(0);
+    bus.cartRam.reset(new CartRam(cartRamSize(header[RAM_SIZE_BYTE_ADDR])));
+    bus.mbc = Mbc::create(bus, header[CARTRIDGE_TYPE_BYTE_ADDR]);
+    bus.cartType = (CartType)header[CARTRIDGE_TYPE_BYTE_ADDR];
+}
+
+template<Permission perm>
+void Memory<perm>::printStatus(){
+    std::cout << "current rom bank: " << (int)bus.currRomBank << std::endl;
+    std::cout << "current ram bank: " << (int)bus.currRamBank << std::endl;
 }
 
-void Memory::printStatus(){
-    std::cout << "current rom bank: " << (int)currRomBank << std::endl;
-    std::cout << "current ram bank: " << (int)currRamBank << std::endl;
-}
\ No newline at end of file
+template class Memory<CPU_PERM>;
+template class Memory<PPU_PERM>;
+template class Memory<DMA_PERM>;
+template class Memory<SYS_PERM>;
+template class Memory<COUNTER_PERM>;
+template class Memory<OAM_PERM>;
+template class Memory<JOYPAD_PERM>;
@@ -12,8 +12,8 @@ bool comp(const Object& obj1, const Object& obj2){
         return obj1.entryNum > obj2.entryNum;
 }
 
-OAM::OAM() :
-mem(OAM_PERM),
+OAM::OAM(Bus& bus) :
+mem(bus),
 lcdcReg(mem.getRegister(LCDC_REG_ADDR))
 {}
 
@@ -3,8 +3,8 @@
 
 
 
-Palette::Palette() :
-    mem(PPU_PERM),
+Palette::Palette(Bus& bus) :
+    mem(bus),
     bgpReg(mem.getRegister(BGP_REG_ADDR)),
     obp0Reg(mem.getRegister(OBP0_REG_ADDR)),
     obp1Reg(mem.getRegister(OBP1_REG_ADDR))
@@ -12,6 +12,26 @@ Palette::Palette() :
     bgpReg = 0xFC;
     obp0Reg = 0x00;
     obp1Reg = 0x00;
+    updatePalette(bgp, bgpReg);
+    updatePalette(obp0, obp0Reg);
+    updatePalette(obp1, obp1Reg);
+    //colors are only decoded again when a palette changes, not for every pixel
+    mem.onWrite(BGP_REG_ADDR, [this](Regval8 byte){
+        updatePalette(bgp, byte);
+    });
+    mem.onWrite(OBP0_REG_ADDR, [this](Regval8 byte){
+        updatePalette(obp0, byte);
+    });
+    mem.onWrite(OBP1_REG_ADDR, [this](Regval8 byte){
+        updatePalette(obp1, byte);
+    });
+}
+
+void Palette::updatePalette(std::array<uint32_t, 4>& colors, Regval8 regVal){
+    const Regval8 masks[] = {COLOR_0_MASK, COLOR_1_MASK, COLOR_2_MASK, COLOR_3_MASK};
+    for(int index = COLOR_0; index <= COLOR_3; index++){
+        colors[index] = convertColor((regVal & masks[index]) >> (2 * index));
+    }
 }
 
 uint32_t Palette::convertColor(Regval8 color){
@@ -36,25 +56,12 @@ uint32_t Palette::convertColor(Regval8 color){
 }
 
 uint32_t Palette::getColor(PaletteSelect select, PaletteIndex index){
-    Regval8 regVal;
-    Regval8 mask;
     switch(select){
-        case BGP:
-            regVal = bgpReg; break;
         case OBP0:
-            regVal = obp0Reg;break;
+            return obp0[index];
         case OBP1:
-            regVal = obp1Reg;break;
-    }
-    switch(index){
-        case COLOR_0:
-            mask = COLOR_0_MASK;break;
-        case COLOR_1:
-            mask = COLOR_1_MASK;break;
-        case COLOR_2:
-            mask = COLOR_2_MASK;break;
-        case COLOR_3:
-            mask = COLOR_3_MASK;break;
+            return obp1[index];
+        default:
+            return bgp[index];
     }
-    return convertColor((regVal & mask) >> (2 * index));
 }
\ No newline at end of file
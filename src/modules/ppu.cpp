@@ -4,8 +4,10 @@
 #include "lcd.h"
 #include "util.h"
 #include <stdexcept>
+#include <cstring>
 #include <iostream>
 #include <chrono>
+#include <algorithm>
 #include <thread>
 /*
 1. fetch two bytes from background map
@@ -28,26 +30,32 @@ TODO:
 */
 
 constexpr double FRAME_RATE = 59.7;
+//for displays that don't report their refresh rate
+constexpr int DEFAULT_REFRESH_RATE = 60;
+//Automatic frame skip skips one more frame once a group of frames keeps the host busy
+//for more than the high share of its time, and one fewer below the low share
+constexpr int MAX_AUTO_FRAMESKIP = 4;
+constexpr double AUTO_SKIP_HIGH_LOAD = 0.9;
+constexpr double AUTO_SKIP_LOW_LOAD = 0.5;
 
-PPU::PPU() : 
-    mem(PPU_PERM), 
+PPU::PPU(Bus& bus) : 
+    signal(bus),
+    mem(bus), 
+    fetcher(bus),
+    oam(bus),
+    palette(bus),
     lcdcReg(mem.getRegister(LCDC_REG_ADDR)),
-    intFlagReg(mem.getRegister(IF_REG_ADDR)),
+    interrupts(bus),
     lyReg(mem.getRegister(LY_REG_ADDR)),
     statReg(mem.getRegister(STAT_REG_ADDR)),
     lycReg(mem.getRegister(LYC_REG_ADDR)),
     winYReg(mem.getRegister(WINY_REG_ADDR)),
-    winXReg(mem.getRegister(WINX_REG_ADDR))
+    winXReg(mem.getRegister(WINX_REG_ADDR)),
+    pacer(FRAME_RATE),
+    presentPacer(DEFAULT_REFRESH_RATE)
 {
-    window = SDL_CreateWindow("JBoy", 
-        SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED,
-        WIN_DIMENSION_SCALE_FACTOR * SCREEN_WIDTH,
-        WIN_DIMENSION_SCALE_FACTOR * SCREEN_HEIGHT,
-        SDL_WINDOW_ALLOW_HIGHDPI);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    windowSurface = SDL_GetWindowSurface(window);
-    frameTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+    sink = &nullSink;
+    frameBuffer = sink->nextFrame().data();
     lcdcReg = 0x91;
     //lyReg = 0x91;
     statReg = 0x81;
@@ -56,44 +64,84 @@ PPU::PPU() :
     state = OAM_SEARCH;
     cyclesLeft = CYCLES_PER_LINE;
     fetchCyclesLeft = 6; 
+    frameLimit = true;
+    speed = SPEED_1X;
+    setFrameSkip(0);
     scanX = 0;
-    lastFrameTime = std::chrono::high_resolution_clock::now();
+    numFrames = 0;
+    presentTime = std::chrono::high_resolution_clock::now();
+    lcdOn = util::checkBit(lcdcReg, LCDC_LCD_EN);
+    lockCpuOut();
+    mem.onWrite(LCDC_REG_ADDR, [this](Regval8 byte){
+        lcdOn = util::checkBit(byte, LCDC_LCD_EN);
+        lockCpuOut();
+    });
 }
 
-PPU::~PPU(){
-    SDL_DestroyWindow(window);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyTexture(frameTexture);
+/*
+The finished frame is only handed to the sink, which mustn't block, so showing
+it is up to the sink and nothing here waits on the GPU.
+*/
+void PPU::updateDisplay() {
+    if(!skippingFrame){
+        sink->submitFrame();
+        frameBuffer = sink->nextFrame().data();
+        presentTime = std::chrono::high_resolution_clock::now();
+        numFrames++;
+    }
+
+    groupBusy += std::chrono::steady_clock::now() - frameStart;
+    if(frameLimit && speed != SPEED_UNCAPPED){
+        pacer.wait();
+    }
+    frameStart = std::chrono::steady_clock::now();
+    skippingFrame = skipNextFrame();
 }
 
+/*
+Decided at the end of each frame for the one after it, so that a skipped frame
+writes none of its pixels. A skipped frame isn't published either, so the last
+one that was stays on screen.
+*/
+bool PPU::skipNextFrame(){
+    if(!sink->showsFrames()){
+        return true;
+    }
+    if(speed == SPEED_UNCAPPED){
+        return !presentPacer.poll();
+    }
+    if(skippedInGroup < skipCount){
+        skippedInGroup++;
+        return true;
+    }
+    if(frameSkip == FRAMESKIP_AUTO){
+        adaptSkipCount();
+    }
+    skippedInGroup = 0;
+    groupStart = frameStart;
+    groupBusy = std::chrono::steady_clock::duration::zero();
+    return false;
+}
 
-void PPU::updateDisplay() {
-    const std::chrono::duration<double> targetFrameDuration(1.0 / FRAME_RATE);
-
-    // Calculate time since the last frame
-    std::chrono::high_resolution_clock::time_point currentTime = std::chrono::high_resolution_clock::now();
-
-    //draw frame
-    Uint32* pixPtr;
-    SDL_LockTexture(frameTexture, NULL, (void**)&pixPtr, &windowSurface->pitch);
-    memcpy((void*)pixPtr, (void*)frameBuffer, sizeof(frameBuffer));
-    SDL_UnlockTexture(frameTexture);
-    SDL_RenderCopy(renderer, frameTexture, NULL, NULL);
-    SDL_RenderPresent(renderer);
-
-    //TODO: Figure out how to make this properly sleep instead for resource/power efficency
-    //spin until frametime has passed
-    while (true){
-        currentTime = std::chrono::high_resolution_clock::now();
-        if((currentTime - lastFrameTime) > targetFrameDuration){
-            lastFrameTime = currentTime;
-            break;
-        }
+//Load is the share of the group's time not spent waiting on the pacer, so it's 1 when behind
+void PPU::adaptSkipCount(){
+    std::chrono::steady_clock::duration elapsed = frameStart - groupStart;
+    if(elapsed <= std::chrono::steady_clock::duration::zero()){
+        return;
+    }
+    double load = std::chrono::duration<double>(groupBusy) / elapsed;
+    if(load > AUTO_SKIP_HIGH_LOAD && skipCount < MAX_AUTO_FRAMESKIP){
+        skipCount++;
+    }
+    else if(load < AUTO_SKIP_LOW_LOAD && skipCount > 0){
+        skipCount--;
     }
 }
 
 void PPU::drawPixel(GbPixel pixel){
-        frameBuffer[(lyReg * SCREEN_WIDTH) + scanX] = palette.getColor(pixel.palette, pixel.paletteIndex);
+        if(!skippingFrame){
+            frameBuffer[(lyReg * SCREEN_WIDTH) + scanX] = palette.getColor(pixel.palette, pixel.paletteIndex);
+        }
         scanX++;
 }
 
@@ -103,6 +151,67 @@ void PPU::printStatus(){
     std::cout << "frame number: " << (int)numFrames << std::endl;
 }
 
+void PPU::setFrameLimit(bool enabled){
+    if(enabled && !frameLimit){
+        pacer.reset();
+    }
+    frameLimit = enabled;
+}
+
+int PPU::getFrameCount(){
+    return numFrames;
+}
+
+std::chrono::high_resolution_clock::time_point PPU::getPresentTime(){
+    return presentTime;
+}
+
+void PPU::setSpeed(SpeedMode mode){
+    static const int multipliers[] = {1, 2, 4};
+    if(mode != SPEED_UNCAPPED){
+        pacer.setRate(FRAME_RATE * multipliers[mode]);
+    }
+    else{
+        presentPacer.reset();
+    }
+    speed = mode;
+}
+
+SpeedMode PPU::getSpeed(){
+    return speed;
+}
+
+void PPU::setRefreshRate(double rate){
+    presentPacer.setRate(rate);
+}
+
+bool PPU::showsFrames(){
+    return sink->showsFrames();
+}
+
+void PPU::setFrameSink(FrameSink* sink){
+    this->sink = sink ? sink : &nullSink;
+    frameBuffer = this->sink->nextFrame().data();
+    skippingFrame = !this->sink->showsFrames();
+}
+
+void PPU::setFrameSkip(int skip){
+    if(skip < FRAMESKIP_AUTO){
+        throw std::logic_error("PPU::setFrameSkip(): Negative frame count.");
+    }
+    frameSkip = skip;
+    skipCount = skip == FRAMESKIP_AUTO ? 0 : skip;
+    skippedInGroup = 0;
+    skippingFrame = !sink->showsFrames();
+    frameStart = std::chrono::steady_clock::now();
+    groupStart = frameStart;
+    groupBusy = std::chrono::steady_clock::duration::zero();
+}
+
+PacerStats PPU::getPacerStats(){
+    return pacer.getStats();
+}
+
 void PPU::changeStatMode(State state){
     switch(state){
         case H_BLANK:
@@ -122,6 +231,20 @@ void PPU::changeStatMode(State state){
         default:
             break;
     }
+    lockCpuOut();
+}
+
+//The CPU can't get at OAM during OAM search and pixel transfer, nor VRAM during the latter
+void PPU::lockCpuOut(){
+    bool drawing = lcdOn && (state == DRAW || state == FETCH_OBJ);
+    if(drawing)
+        mem.lockVram();
+    else
+        mem.unlockVram();
+    if(drawing || (lcdOn && state == OAM_SEARCH))
+        mem.lockOam();
+    else
+        mem.unlockOam();
 }
 
 void PPU::runFSM(){
@@ -160,7 +283,7 @@ void PPU::runFSM(){
                 drawPixel(pixel);
                 if(scanX == SCREEN_WIDTH){
                     if(statReg & STAT_HBLANK_ENABLE_MASK){
-                        intFlagReg |= LCD_STAT_INT;
+                        interrupts.raise(LCD_STAT_INT);
                     }
                     state = H_BLANK;
                     changeStatMode(state);
@@ -185,7 +308,7 @@ void PPU::runFSM(){
                 ++lyReg;
                 if((lyReg == lycReg) && (statReg & STAT_LYC_ENABLE_MASK)){
                     statReg |= STAT_LYC_FLAG_MASK;
-                    intFlagReg |= LCD_STAT_INT;
+                    interrupts.raise(LCD_STAT_INT);
                 }
 
                 //if done scanning, transition to V_BLANK and draw frame 
@@ -194,9 +317,9 @@ void PPU::runFSM(){
                     state = V_BLANK;
                     signal.raiseSignal(FRAME_SIGNAL);
                     if(statReg & STAT_VBLANK_ENABLE_MASK){
-                        intFlagReg |= LCD_STAT_INT;
+                        interrupts.raise(LCD_STAT_INT);
                     }
-                    intFlagReg |= VBLANK_INT;
+                    interrupts.raise(VBLANK_INT);
                     cyclesLeft = CYCLES_PER_LINE * 10;
                     //FIXME: Changing stat reg to VBLANK mode breaks Dr. Mario
                     //changeStatMode(state);
@@ -235,7 +358,76 @@ void PPU::runFSM(){
 }
 
 void PPU::emulateCycle(){
-    if(util::checkBit(lcdcReg, LCDC_LCD_EN)){
+    if(lcdOn){
         runFSM(); 
     }
+}
+
+void PPU::emulateCycles(int n){
+    if(!lcdOn){
+        return;
+    }
+    while(n > 0){
+        int skipped = skipIdleCycles(n);
+        n -= skipped;
+        if(n > 0){
+            runFSM();
+            n--;
+        }
+    }
+}
+
+/*
+Outside of pixel transfer, runFSM() only counts cycles down until the next mode
+change. This does up to n of those cycles at once and returns how many it did,
+stopping right before any cycle that has more to do.
+*/
+int PPU::skipIdleCycles(int n){
+    int skip = 0;
+    switch(state){
+        case OAM_SEARCH:
+            skip = std::min(n, cyclesLeft - (CYCLES_PER_LINE - OAM_CYCLES));
+            cyclesLeft -= skip;
+            break;
+        case H_BLANK:
+            skip = std::min(n, cyclesLeft);
+            cyclesLeft -= skip;
+            break;
+        case V_BLANK:{
+            if(cyclesLeft <= 0){
+                break;
+            }
+            skip = std::min(n, cyclesLeft);
+            //LY steps each time the count lands on a line boundary
+            int lineSteps = (cyclesLeft - 1) / CYCLES_PER_LINE + 1;
+            int lineStepsLeft = cyclesLeft - skip == 0 ? 0 : (cyclesLeft - skip - 1) / CYCLES_PER_LINE + 1;
+            lyReg += lineSteps - lineStepsLeft;
+            cyclesLeft -= skip;
+            break;
+        }
+        default:
+            break;
+    }
+    return skip;
+}
+
+int PPU::cyclesUntilEvent(){
+    if(!lcdOn){
+        return NO_EVENT;
+    }
+    switch(state){
+        case OAM_SEARCH:
+            return cyclesLeft - (CYCLES_PER_LINE - OAM_CYCLES);
+        case H_BLANK:
+            return cyclesLeft;
+        case V_BLANK:
+            if(cyclesLeft <= 0){
+                return 0;
+            }
+            //LY still steps once per line during vertical blank
+            return (cyclesLeft - 1) % CYCLES_PER_LINE;
+        default:
+            //at most one pixel is drawn per cycle
+            return std::max(SCREEN_WIDTH - scanX - 1, 0);
+    }
 }
\ No newline at end of file
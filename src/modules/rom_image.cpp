@@ -0,0 +1,159 @@
+#include "rom_image.h"
+#include "memory.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325;
+constexpr uint64_t FNV_PRIME = 0x100000001B3;
+
+std::mutex RomImage::cacheLock;
+std::unordered_map<uint64_t, std::vector<std::weak_ptr<const RomImage>>> RomImage::cache;
+
+/*
+The file is mapped before the cache is checked, since its contents are the
+key. A duplicate is unmapped again right away, having only been read once
+to hash it.
+*/
+std::shared_ptr<const RomImage> RomImage::open(const std::string& filename){
+    std::shared_ptr<const RomImage> image = std::make_shared<const RomImage>(filename);
+    std::lock_guard<std::mutex> lock(cacheLock);
+    std::vector<std::weak_ptr<const RomImage>>& entries = cache[image->getHash()];
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [](const std::weak_ptr<const RomImage>& entry){
+            return entry.expired();
+        }), entries.end());
+    for(const std::weak_ptr<const RomImage>& entry : entries){
+        std::shared_ptr<const RomImage> cached = entry.lock();
+        if(cached && cached->sameContents(*image)){
+            return cached;
+        }
+    }
+    entries.push_back(image);
+    return image;
+}
+
+RomImage::RomImage(const std::string& filename){
+    bytes = nullptr;
+    size = 0;
+    mapping = nullptr;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        throw std::invalid_argument("RomImage::RomImage(): Failed to open requested gb file.");
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size = fileSize.QuadPart;
+    if(size && size % ROM_BANK_SIZE == 0){
+        HANDLE view = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(view){
+            mapping = MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(view);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::invalid_argument("RomImage::RomImage(): Failed to open requested gb file.");
+    }
+    struct stat info;
+    if(fstat(fd, &info) == 0){
+        size = info.st_size;
+    }
+    if(size && size % ROM_BANK_SIZE == 0){
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        mapping = addr == MAP_FAILED ? nullptr : addr;
+    }
+    ::close(fd);
+#endif
+    if(mapping){
+        bytes = (const Regval8*)mapping;
+    }
+    else{
+        readFile(filename);
+    }
+    numBanks = size / ROM_BANK_SIZE;
+    if(size > ROM_SIZE_BYTE_ADDR){
+        numBanks = std::max(numBanks, headerBankCount(bytes[ROM_SIZE_BYTE_ADDR]));
+    }
+    //images are whole banks, so they always split evenly into words
+    hash = FNV_OFFSET_BASIS;
+    for(size_t i = 0; i < size; i += sizeof(uint64_t)){
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+}
+
+RomImage::~RomImage(){
+    if(!mapping){
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+//A partial last bank can't be mapped without faulting past the end of the file
+void RomImage::readFile(const std::string& filename){
+    std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+    if(file.fail()){
+        throw std::invalid_argument("RomImage::RomImage(): Failed to open requested gb file.");
+    }
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    size_t padded = (buffer.size() + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE * ROM_BANK_SIZE;
+    buffer.resize(std::max(padded, (size_t)ROM_BANK_SIZE), 0);
+    bytes = buffer.data();
+    size = buffer.size();
+}
+
+bool RomImage::sameContents(const RomImage& other) const{
+    return size == other.size && hash == other.hash && !memcmp(bytes, other.bytes, size);
+}
+
+int RomImage::headerBankCount(Regval8 sizeCode){
+    switch(sizeCode){
+        case 0x52:
+            return 72;
+        case 0x53:
+            return 80;
+        case 0x54:
+            return 96;
+        default:
+            //32 KiB << code, the largest carts made hold 8 MiB
+            return sizeCode <= 0x08 ? 2 << sizeCode : 0;
+    }
+}
+
+const Regval8* RomImage::getBank(int bank) const{
+    if((size_t)bank >= size / ROM_BANK_SIZE){
+        return nullptr;
+    }
+    return bytes + (size_t)bank * ROM_BANK_SIZE;
+}
+
+int RomImage::getNumBanks() const{
+    return numBanks;
+}
+
+size_t RomImage::getSize() const{
+    return size;
+}
+
+uint64_t RomImage::getHash() const{
+    return hash;
+}
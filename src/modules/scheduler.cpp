@@ -0,0 +1,41 @@
+#include "scheduler.h"
+
+bool Scheduler::Later::operator()(const Event& e1, const Event& e2) const{
+    return e1.time > e2.time;
+}
+
+Scheduler::Scheduler(){
+    deadlines.fill(NEVER);
+}
+
+void Scheduler::dropStale(){
+    while(!events.empty() && events.top().time != deadlines[events.top().type]){
+        events.pop();
+    }
+}
+
+void Scheduler::schedule(EventType type, uint64_t time){
+    if(deadlines[type] == time){
+        return;
+    }
+    deadlines[type] = time;
+    if(time != NEVER){
+        events.push({time, type});
+    }
+}
+
+void Scheduler::cancel(EventType type){
+    deadlines[type] = NEVER;
+}
+
+uint64_t Scheduler::nextEventTime(){
+    dropStale();
+    if(events.empty()){
+        return NEVER;
+    }
+    return events.top().time;
+}
+
+uint64_t Scheduler::getDeadline(EventType type){
+    return deadlines[type];
+}
\ No newline at end of file
@@ -2,34 +2,32 @@
 #include <stdexcept>
 #include <iostream>
 
-Regval16 Signal::flags = 0;
-Regval16 Signal::flagEnable = 0;
-Signal::Signal(){
+Signal::Signal(Bus& bus) : bus(bus){
 }
 
 bool Signal::checkFlag(Regval16 mask){
-    if(flags & mask){
+    if(bus.signalFlags & mask){
         return true;
     }
     return false;
 }
 
 void Signal::clearSignal(Regval16 mask){
-    flags &= ~mask;
+    bus.signalFlags &= ~mask;
 }
 
 void Signal::raiseSignal(Regval16 mask){
-    if(flagEnable & mask){
-        flags |= mask;
+    if(bus.signalEnable & mask){
+        bus.signalFlags |= mask;
     }
 }
 
 void Signal::enableSignal(Regval16 mask){
-    flagEnable |= mask;
+    bus.signalEnable |= mask;
 }
 
 bool Signal::signalRaised(Regval16 mask){
-    if(flags & flagEnable & mask){
+    if(bus.signalFlags & bus.signalEnable & mask){
         clearSignal(mask);
         return true;
     }
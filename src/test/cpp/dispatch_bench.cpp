@@ -0,0 +1,57 @@
+#include "gameboy.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+
+constexpr long DEFAULT_BENCH_CYCLES = 100000000;
+
+/*
+Runs a ROM uncapped for a fixed number of cycles and reports throughput,
+used to measure the cost of opcode dispatch and the rest of the core.
+usage: dispatchbench <rom> [cycles] [--instruction-step | --jit]
+*/
+int main(int argc, char** argv){
+    if(argc < 2){
+        cout << "usage: " << argv[0] << " <rom> [cycles] [--instruction-step | --jit]" << endl;
+        return 1;
+    }
+    long numCycles = argc > 2 ? stol(argv[2]) : DEFAULT_BENCH_CYCLES;
+    Gameboy gb;
+    gb.setFrameLimit(false);
+    gb.loadGame(string(argv[1]));
+    if(argc > 3 && string(argv[3]) == "--instruction-step"){
+        gb.setRunMode(INSTRUCTION_STEP);
+    }
+    else if(argc > 3 && string(argv[3]) == "--jit"){
+        gb.setRunMode(INSTRUCTION_STEP);
+        gb.setJitEnabled(true);
+    }
+
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    try{
+        while((long)gb.getCycleCount() < numCycles){
+            gb.step();
+        }
+    }
+    catch(exception& e){
+        cout << "stopped early: " << e.what();
+    }
+    chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+    long cycles = gb.getCycleCount();
+
+    double cyclesPerSec = cycles / elapsed.count();
+    cout << "cycles:      " << cycles << endl;
+    cout << "seconds:     " << elapsed.count() << endl;
+    cout << "cycles/sec:  " << (long)cyclesPerSec << endl;
+    cout << "speed:       " << cyclesPerSec / CYCLE_RATE << "x" << endl;
+    SkipStats skipped = gb.getSkipStats();
+    cout << "halt skip:   " << skipped.haltCycles << endl;
+    cout << "idle skip:   " << skipped.idleLoopCycles << endl;
+    MemoryStats memory = gb.getMemoryStats();
+    cout << "instance:    " << memory.instanceBytes / 1024 << " KiB" << endl;
+    cout << "shared rom:  " << memory.sharedRomBytes / 1024 << " KiB, " << memory.romUsers << " user(s)" << endl;
+    return 0;
+}
@@ -0,0 +1,597 @@
+#include "gameboy.h"
+#include "triple_buffer.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <memory>
+#include <utility>
+
+using namespace std;
+
+constexpr char GREEN[] = "\033[32m";
+constexpr char RED[] = "\033[31m";
+constexpr char RESET[] = "\033[0m";
+
+constexpr int NUM_TEST_CYCLES = 200000;
+constexpr Regval16 MARKER_ADDR = 0xC000;
+constexpr Regval16 COUNTER_ADDR = 0xC001;
+//Where test programs start, past the header
+constexpr Regval16 PROGRAM_ADDR = 0x150;
+constexpr int NUM_DMA_TEST_BYTES = 8;
+//Longest an instruction step can take, an interrupt dispatch and CALL
+constexpr int MAX_INSTR_CYCLES = 48;
+constexpr uint32_t NUM_PUBLISHED_FRAMES = 20000;
+
+int numFailures = 0;
+
+void colorPrint(const char* color, const char* s){
+    cout << color << s << RESET << endl;
+}
+
+void check(bool passed){
+    if(passed){
+        colorPrint(GREEN, "SUCCESS");
+    }
+    else{
+        colorPrint(RED, "FAILURE");
+        numFailures++;
+    }
+}
+
+/*
+Lays code into a ROM image at the given address.
+*/
+void placeCode(string& rom, const vector<Regval8>& code, size_t at){
+    for(size_t i = 0; i < code.size(); i++)
+        rom[at + i] = code[i];
+}
+
+/*
+Puts a program in a ROM image at the given address, along with an entry point
+that jumps to it, and writes the image out. Anything else the ROM needs, like
+an ISR, a header or the contents of other banks, goes into the image first.
+*/
+void writeRom(string filename, const vector<Regval8>& program, Regval16 at = PROGRAM_ADDR,
+    string rom = string(2 * ROM_BANK_SIZE, 0x00)){
+    placeCode(rom, {
+        0x00,                                           //NOP
+        0xC3, (Regval8)(at & 0xFF), (Regval8)(at >> 8)  //JP at
+    }, 0x100);
+    placeCode(rom, program, at);
+    ofstream out(filename, ios_base::out | ios_base::binary);
+    out.write(rom.data(), rom.size());
+}
+
+/*
+Builds a two bank ROM that stores a marker byte in WRAM, then spins on
+INC (HL) or DEC (HL) so the two instances diverge every iteration.
+Bank 1 is filled with a fill byte so the switchable bank can be told apart.
+*/
+void createRom(string filename, Regval8 marker, Regval8 loopOp, Regval8 fill){
+    string rom(2 * ROM_BANK_SIZE, 0x00);
+    for(int i = ROM_BANK_SIZE; i < 2 * ROM_BANK_SIZE; i++)
+        rom[i] = fill;
+    writeRom(filename, {
+        0x3E, marker,           //LD A, marker
+        0xEA, 0x00, 0xC0,       //LD ($C000), A
+        0x21, 0x01, 0xC0,       //LD HL, $C001
+        loopOp,                 //INC (HL) / DEC (HL)
+        0x18, 0xFD              //JR -3
+    }, PROGRAM_ADDR, rom);
+}
+
+/*
+Builds a ROM that waits for vblank by polling LY, counts the frame in WRAM,
+then waits for LY to leave vblank again, the way games without HALT do.
+*/
+void createPollRom(string filename){
+    writeRom(filename, {
+        0x21, 0x01, 0xC0,       //LD HL, $C001
+        0xF0, 0x44,             //LDH A, (LY)
+        0xFE, 0x90,             //CP 144
+        0x20, 0xFA,             //JR NZ, -6
+        0x34,                   //INC (HL)
+        0xF0, 0x44,             //LDH A, (LY)
+        0xFE, 0x90,             //CP 144
+        0x28, 0xFA,             //JR Z, -6
+        0x18, 0xF1              //JR -15
+    });
+}
+
+/*
+Builds a ROM that waits for VRAM to be locked by pixel transfer and to become
+readable again, polling it the way some games do, and counts the transfers.
+*/
+void createVramPollRom(string filename){
+    writeRom(filename, {
+        0x21, 0x01, 0xC0,       //LD HL, $C001
+        0xFA, 0x00, 0x80,       //LD A, ($8000)
+        0xFE, 0xFF,             //CP $FF
+        0x28, 0xF9,             //JR Z, -7
+        0x34,                   //INC (HL)
+        0xFA, 0x00, 0x80,       //LD A, ($8000)
+        0xFE, 0xFF,             //CP $FF
+        0x20, 0xF9,             //JR NZ, -7
+        0x18, 0xEF              //JR -17
+    });
+}
+
+/*
+Builds a ROM that copies a routine into WRAM and keeps calling it. The routine
+bumps its own LD A immediate and stores it to the counter, so a stale decoded
+copy of it shows up as a counter that stops moving.
+*/
+void createSelfModifyingRom(string filename){
+    const Regval8 routine[] = {
+        0x3E, 0x00,             //LD A, 0
+        0x3C,                   //INC A
+        0xEA, 0x01, 0xC1,       //LD ($C101), A
+        0xEA, 0x01, 0xC0,       //LD ($C001), A
+        0xC9                    //RET
+    };
+    vector<Regval8> program = {
+        0x31, 0x00, 0xD0,       //LD SP, $D000
+        0x21, 0x00, 0xC1        //LD HL, $C100
+    };
+    for(Regval8 byte : routine){
+        program.insert(program.end(), {0x3E, byte, 0x22});  //LD A, byte / LD (HL+), A
+    }
+    program.insert(program.end(), {0xCD, 0x00, 0xC1});      //CALL $C100
+    program.insert(program.end(), {0x18, 0xFB});            //JR -5
+    writeRom(filename, program);
+}
+
+/*
+Builds a ROM that fills a page of WRAM, starts an OAM DMA from it and turns
+on the timer, then spins. Both only happen if the register writes reach them.
+*/
+void createRegisterWriteRom(string filename){
+    vector<Regval8> program = {
+        0x21, 0x00, 0xC1        //LD HL, $C100
+    };
+    for(int i = 0; i < NUM_DMA_TEST_BYTES; i++){
+        program.insert(program.end(), {0x3E, (Regval8)(0xA0 + i), 0x22});    //LD A, byte / LD (HL+), A
+    }
+    program.insert(program.end(), {
+        0x3E, 0xC1,             //LD A, $C1
+        0xE0, 0x46,             //LDH (DMA), A
+        0x3E, 0x05,             //LD A, 5
+        0xE0, 0x07,             //LDH (TAC), A
+        0x18, 0xFE              //JR -2
+    });
+    writeRom(filename, program);
+}
+
+/*
+Builds a ROM that runs into the HALT bug with a timer interrupt already pending,
+then enables it with EI. INC A runs twice after the HALT, and once more after EI
+before the ISR stores A.
+*/
+void createInterruptRom(string filename){
+    string rom(2 * ROM_BANK_SIZE, 0x00);
+    placeCode(rom, {
+        0xEA, 0x03, 0xC0,       //LD ($C003), A
+        0xD9                    //RETI
+    }, TIMER_ISR_ADDR);
+    writeRom(filename, {
+        0x31, 0x00, 0xD0,       //LD SP, $D000
+        0x3E, TIMER_INT,        //LD A, TIMER_INT
+        0xE0, 0xFF,             //LDH (IE), A
+        0xE0, 0x0F,             //LDH (IF), A
+        0xAF,                   //XOR A
+        0x76,                   //HALT
+        0x3C,                   //INC A
+        0xEA, 0x01, 0xC0,       //LD ($C001), A
+        0xFB,                   //EI
+        0x3C,                   //INC A
+        0xEA, 0x02, 0xC0,       //LD ($C002), A
+        0x18, 0xFE              //JR -2
+    }, PROGRAM_ADDR, rom);
+}
+
+/*
+Builds a ROM that selects the action buttons and keeps rewriting JOYP with
+the joypad interrupt enabled. The ISR counts itself and stores what JOYP reads.
+*/
+void createJoypadRom(string filename){
+    string rom(2 * ROM_BANK_SIZE, 0x00);
+    placeCode(rom, {
+        0xF0, 0x00,             //LDH A, (JOYP)
+        0xEA, 0x00, 0xC0,       //LD ($C000), A
+        0x21, 0x01, 0xC0,       //LD HL, $C001
+        0x34,                   //INC (HL)
+        0xD9                    //RETI
+    }, JOYPAD_ISR_ADDR);
+    writeRom(filename, {
+        0x31, 0x00, 0xD0,       //LD SP, $D000
+        0x3E, JOYPAD_INT,       //LD A, JOYPAD_INT
+        0xE0, 0xFF,             //LDH (IE), A
+        0xFB,                   //EI
+        0x3E, 0x10,             //LD A, $10
+        0xE0, 0x00,             //LDH (JOYP), A
+        0x18, 0xFA              //JR -6
+    }, PROGRAM_ADDR, rom);
+}
+
+/*
+Builds an MBC3 ROM of any size whose banks each start with their own number.
+The program switches to the last bank it can select and copies that byte to
+the marker.
+*/
+void createBankedRom(string filename, Regval8 sizeCode, size_t fileSize){
+    string rom(fileSize, 0x00);
+    for(size_t bank = 1; bank * ROM_BANK_SIZE < fileSize; bank++)
+        rom[bank * ROM_BANK_SIZE] = (char)bank;
+    rom[0x147] = MBC3;
+    rom[ROM_SIZE_BYTE_ADDR] = sizeCode;
+    writeRom(filename, {
+        0x3E, 0x7F,             //LD A, $7F
+        0xEA, 0x00, 0x20,       //LD ($2000), A
+        0xFA, 0x00, 0x40,       //LD A, ($4000)
+        0xEA, 0x00, 0xC0,       //LD ($C000), A
+        0x18, 0xFE              //JR -2
+    }, PROGRAM_ADDR, rom);
+}
+
+void runTo(Gameboy& gb, uint64_t cycles){
+    while(gb.getCycleCount() < cycles){
+        gb.step();
+    }
+}
+
+/*
+Runs a ROM on two machines, one stepping instructions for at least the given
+number of cycles and one stepping cycles until it has caught up with it, so
+the two can be compared at the same cycle.
+*/
+pair<unique_ptr<Gameboy>, unique_ptr<Gameboy>> runBothModes(string rom, uint64_t cycles){
+    unique_ptr<Gameboy> cycleStepped(new Gameboy());
+    unique_ptr<Gameboy> instrStepped(new Gameboy());
+    cycleStepped->loadGame(rom);
+    instrStepped->loadGame(rom);
+    instrStepped->setRunMode(INSTRUCTION_STEP);
+    runTo(*instrStepped, cycles);
+    runTo(*cycleStepped, instrStepped->getCycleCount());
+    return {std::move(cycleStepped), std::move(instrStepped)};
+}
+
+bool sameState(Gameboy& gb1, Gameboy& gb2){
+    GbState s1 = gb1.getState();
+    GbState s2 = gb2.getState();
+    for(int i = 0; i < NUM_REGS_8; i++){
+        if(s1.regs_8[i] != s2.regs_8[i])
+            return false;
+    }
+    for(int i = 0; i < NUM_REGS_16; i++){
+        if(s1.regs_16[i] != s2.regs_16[i])
+            return false;
+    }
+    return gb1.readMem(MARKER_ADDR) == gb2.readMem(MARKER_ADDR) &&
+        gb1.readMem(COUNTER_ADDR) == gb2.readMem(COUNTER_ADDR);
+}
+
+//Same state and at the same point of the frame, with the same timer and interrupts
+bool sameTiming(Gameboy& gb1, Gameboy& gb2){
+    return sameState(gb1, gb2) &&
+        gb1.readMem(LY_REG_ADDR) == gb2.readMem(LY_REG_ADDR) &&
+        gb1.readMem(STAT_REG_ADDR) == gb2.readMem(STAT_REG_ADDR) &&
+        gb1.readMem(DIV_REG_ADDR) == gb2.readMem(DIV_REG_ADDR) &&
+        gb1.readMem(IF_REG_ADDR) == gb2.readMem(IF_REG_ADDR);
+}
+
+int main(int argc, char** argv){
+    const string romA = "isolation_a.gb";
+    const string romB = "isolation_b.gb";
+    createRom(romA, 0xAA, 0x34, 0x11);
+    createRom(romB, 0x55, 0x35, 0x22);
+
+    Gameboy gbA;
+    Gameboy gbB;
+    Gameboy reference;
+    gbA.loadGame(romA);
+    gbB.loadGame(romB);
+    reference.loadGame(romA);
+
+    //step both instances in lockstep
+    for(int i = 0; i < NUM_TEST_CYCLES; i++){
+        gbA.emulateCycle();
+        gbB.emulateCycle();
+    }
+    //the reference runs alone, with nothing interleaved
+    for(int i = 0; i < NUM_TEST_CYCLES; i++){
+        reference.emulateCycle();
+    }
+
+    cout << "Isolated ROM banks Test" << endl;
+    check(gbA.readMem(ROM_BANK_N_START) == 0x11 && gbB.readMem(ROM_BANK_N_START) == 0x22);
+
+    cout << "Isolated WRAM Test" << endl;
+    check(gbA.readMem(MARKER_ADDR) == 0xAA && gbB.readMem(MARKER_ADDR) == 0x55);
+
+    cout << "Divergent Execution Test" << endl;
+    check(gbA.readMem(COUNTER_ADDR) != gbB.readMem(COUNTER_ADDR) &&
+        (Regval8)(gbA.readMem(COUNTER_ADDR) + gbB.readMem(COUNTER_ADDR)) == 0);
+
+    cout << "Interleaved Matches Standalone Test" << endl;
+    check(sameState(gbA, reference));
+
+    cout << "Isolated Signals Test" << endl;
+    gbA.enableSignal(FRAME_SIGNAL);
+    bool raisedA = false;
+    bool raisedB = false;
+    for(int i = 0; i < CYCLES_PER_LINE * SCAN_HEIGHT * 2; i++){
+        gbA.emulateCycle();
+        gbB.emulateCycle();
+        raisedA |= gbA.signalRaised(FRAME_SIGNAL);
+        raisedB |= gbB.signalRaised(FRAME_SIGNAL);
+    }
+    check(raisedA && !raisedB);
+
+    cout << "Instruction Step Matches Cycle Step Test" << endl;
+    auto [cycleStepped, instrStepped] = runBothModes(romA, NUM_TEST_CYCLES);
+    check(sameTiming(*cycleStepped, *instrStepped));
+
+    cout << "Idle Loop Skip Test" << endl;
+    const string romPoll = "idle_poll.gb";
+    createPollRom(romPoll);
+    auto [cyclePoll, instrPoll] = runBothModes(romPoll, CYCLES_PER_LINE * SCAN_HEIGHT * 4);
+    check(instrPoll->getSkipStats().idleLoopCycles > 0 && instrPoll->readMem(COUNTER_ADDR) > 0 &&
+        sameTiming(*cyclePoll, *instrPoll));
+
+    cout << "VRAM Poll Skip Test" << endl;
+    //reads of VRAM change with the PPU mode, so a loop polling it must wake on mode changes
+    const string romVramPoll = "vram_poll.gb";
+    createVramPollRom(romVramPoll);
+    auto [cycleVram, instrVram] = runBothModes(romVramPoll, CYCLES_PER_LINE * SCAN_HEIGHT * 2);
+    check(cycleVram->readMem(COUNTER_ADDR) > 0 && sameTiming(*cycleVram, *instrVram));
+    remove(romVramPoll.c_str());
+
+    cout << "Shared ROM Test" << endl;
+    //same contents under another name still share the image
+    const string romPollCopy = "idle_poll_copy.gb";
+    createPollRom(romPollCopy);
+    long pollUsers = instrPoll->getMemoryStats().romUsers;
+    bool shared;
+    {
+        Gameboy sharer;
+        sharer.loadGame(romPollCopy);
+        MemoryStats stats = sharer.getMemoryStats();
+        shared = stats.romUsers == pollUsers + 1 && instrPoll->getMemoryStats().romUsers == pollUsers + 1 &&
+            stats.sharedRomBytes == 2 * ROM_BANK_SIZE && stats.instanceBytes < 1024 * 1024;
+    }
+    check(shared && pollUsers == 2 && instrPoll->getMemoryStats().romUsers == pollUsers);
+    remove(romPollCopy.c_str());
+
+    cout << "Self-Modifying Code Test" << endl;
+    const string romSmc = "self_modifying.gb";
+    createSelfModifyingRom(romSmc);
+    auto [cycleSmc, instrSmc] = runBothModes(romSmc, NUM_TEST_CYCLES);
+    check(sameTiming(*cycleSmc, *instrSmc) && instrSmc->readMem(COUNTER_ADDR) > 1);
+
+    cout << "Register Write Hooks Test" << endl;
+    const string romRegs = "register_writes.gb";
+    createRegisterWriteRom(romRegs);
+    auto [cycleRegs, instrRegs] = runBothModes(romRegs, NUM_TEST_CYCLES);
+    bool copied = true;
+    for(int i = 0; i < NUM_DMA_TEST_BYTES; i++){
+        copied &= instrRegs->readMem(OAM_START + i) == 0xA0 + i && cycleRegs->readMem(OAM_START + i) == 0xA0 + i;
+    }
+    check(copied && sameTiming(*cycleRegs, *instrRegs) &&
+        cycleRegs->readMem(TIMA_REG_ADDR) == instrRegs->readMem(TIMA_REG_ADDR) &&
+        cycleRegs->readMem(IF_REG_ADDR) & TIMER_INT);
+
+    remove(romA.c_str());
+    remove(romB.c_str());
+    remove(romPoll.c_str());
+    remove(romSmc.c_str());
+    remove(romRegs.c_str());
+
+    cout << "Interrupt Timing Test" << endl;
+    const string romInts = "interrupts.gb";
+    createInterruptRom(romInts);
+    auto [cycleInts, instrInts] = runBothModes(romInts, NUM_TEST_CYCLES);
+    bool timed = true;
+    for(Gameboy* gb : {cycleInts.get(), instrInts.get()}){
+        timed &= gb->readMem(COUNTER_ADDR) == 2 && gb->readMem(0xC003) == 3 &&
+            gb->readMem(0xC002) == 3 && !(gb->readMem(IF_REG_ADDR) & TIMER_INT);
+    }
+    check(timed);
+    remove(romInts.c_str());
+
+    cout << "Joypad Input Test" << endl;
+    const string romJoypad = "joypad.gb";
+    createJoypadRom(romJoypad);
+    //A pressed, released, pressed again, then Down, which isn't selected
+    const vector<JoypadEvent> input = {
+        {50000, (Regval8)~A_BUTTON_MASK},
+        {60000, JOYPAD_RELEASED},
+        {70000, (Regval8)~A_BUTTON_MASK},
+        {80000, (Regval8)~(A_BUTTON_MASK | DOWN_PAD_MASK)}
+    };
+    Gameboy cycleJoypad;
+    Gameboy instrJoypad;
+    cycleJoypad.loadGame(romJoypad);
+    instrJoypad.loadGame(romJoypad);
+    instrJoypad.setRunMode(INSTRUCTION_STEP);
+    //one gets the whole recording up front, the other each event as it comes due
+    for(const JoypadEvent& event : input){
+        cycleJoypad.queueInput(event.cycle, event.state);
+    }
+    size_t nextEvent = 0;
+    while(instrJoypad.getCycleCount() < NUM_TEST_CYCLES){
+        if(nextEvent < input.size() && instrJoypad.getCycleCount() + MAX_INSTR_CYCLES >= input[nextEvent].cycle){
+            instrJoypad.queueInput(input[nextEvent].cycle, input[nextEvent].state);
+            nextEvent++;
+        }
+        instrJoypad.step();
+    }
+    runTo(cycleJoypad, instrJoypad.getCycleCount());
+    check(sameState(cycleJoypad, instrJoypad) && cycleJoypad.readMem(COUNTER_ADDR) == 2 &&
+        cycleJoypad.readMem(MARKER_ADDR) == 0xDE && cycleJoypad.getJoypad() == input.back().state);
+
+    cout << "Input Log Order Test" << endl;
+    Gameboy logJoypad;
+    logJoypad.loadGame(romJoypad);
+    logJoypad.setInputRecording(true);
+    //the second event is stamped before the first, so it's logged where it ended up
+    logJoypad.queueInput(2000, (Regval8)~A_BUTTON_MASK);
+    logJoypad.queueInput(1000, JOYPAD_RELEASED);
+    const vector<JoypadEvent>& inputLog = logJoypad.getInputLog();
+    check(inputLog.size() == 2 && inputLog[0].cycle == 2000 && inputLog[1].cycle == 2000 &&
+        inputLog[1].state == JOYPAD_RELEASED);
+
+    cout << "Input Log File Test" << endl;
+    const string logFile = "input.log";
+    bool logRead = Joypad::saveInputLog(logFile, input) && Joypad::loadInputLog(logFile).size() == input.size() &&
+        Joypad::loadInputLog(logFile).back().cycle == input.back().cycle;
+    ofstream(logFile) << "50000 fe\n60000 zz\n";
+    bool malformedThrows = false;
+    try{
+        Joypad::loadInputLog(logFile);
+    }
+    catch(std::invalid_argument&){
+        malformedThrows = true;
+    }
+    remove(logFile.c_str());
+    bool missingThrows = false;
+    try{
+        Joypad::loadInputLog(logFile);
+    }
+    catch(std::invalid_argument&){
+        missingThrows = true;
+    }
+    check(logRead && malformedThrows && missingThrows);
+    remove(romJoypad.c_str());
+
+    cout << "ROM Mapping Test" << endl;
+    const string romLarge = "large.gb";
+    const string romOdd = "unaligned.gb";
+    //4 MiB, well past what MBC1 can address
+    createBankedRom(romLarge, 0x07, 256 * ROM_BANK_SIZE);
+    //a header claiming 32 KiB over a file that stops partway into bank 1
+    createBankedRom(romOdd, 0x00, ROM_BANK_SIZE + 0x100);
+    Gameboy large;
+    Gameboy odd;
+    size_t largeSize = large.loadGame(romLarge);
+    size_t oddSize = odd.loadGame(romOdd);
+    for(int i = 0; i < NUM_TEST_CYCLES; i++){
+        large.emulateCycle();
+        odd.emulateCycle();
+    }
+    check(largeSize == 256 * ROM_BANK_SIZE && large.readMem(MARKER_ADDR) == 0x7F &&
+        oddSize == 2 * ROM_BANK_SIZE && odd.readMem(ROM_BANK_N_START + 0x200) == 0x00);
+    remove(romLarge.c_str());
+    remove(romOdd.c_str());
+
+    cout << "Frame Skip Timing Test" << endl;
+    //skipped frames aren't drawn but must run exactly as drawn ones do
+    const string romSkip = "frame_skip.gb";
+    createPollRom(romSkip);
+    Gameboy drawn;
+    Gameboy skipped;
+    drawn.loadGame(romSkip);
+    skipped.loadGame(romSkip);
+    drawn.setFrameLimit(false);
+    skipped.setFrameLimit(false);
+    skipped.setFrameSkip(2);
+    runTo(drawn, CYCLES_PER_LINE * SCAN_HEIGHT * 8);
+    runTo(skipped, drawn.getCycleCount());
+    check(drawn.readMem(COUNTER_ADDR) > 0 && sameTiming(drawn, skipped));
+
+    cout << "Triple Buffer Test" << endl;
+    //every frame taken must be whole and no older than the one before it
+    TripleBuffer<FrameBuffer> frames;
+    thread producer([&frames](){
+        for(uint32_t frame = 1; frame <= NUM_PUBLISHED_FRAMES; frame++){
+            frames.getBack().fill(frame);
+            frames.publish();
+        }
+    });
+    bool torn = false;
+    bool reordered = false;
+    uint32_t lastTaken = 0;
+    while(lastTaken != NUM_PUBLISHED_FRAMES){
+        if(frames.fetch()){
+            const FrameBuffer& front = frames.getFront();
+            torn |= front.back() != front.front();
+            reordered |= front.front() <= lastTaken;
+            lastTaken = front.front();
+        }
+    }
+    producer.join();
+    check(!torn && !reordered && !frames.fetch());
+
+    cout << "Frame Sink Test" << endl;
+    //a skipping machine submits every other frame, the same as the one drawing all of them
+    MemoryFrameSink everyFrame;
+    MemoryFrameSink everyOther;
+    Gameboy drawAll;
+    Gameboy drawHalf;
+    Gameboy drawNone;
+    drawAll.loadGame(romSkip);
+    drawHalf.loadGame(romSkip);
+    drawNone.loadGame(romSkip);
+    drawAll.setFrameSink(&everyFrame);
+    drawHalf.setFrameSink(&everyOther);
+    drawHalf.setFrameSkip(1);
+    for(Gameboy* gb : {&drawAll, &drawHalf, &drawNone}){
+        gb->setFrameLimit(false);
+        gb->enableSignal(FRAME_SIGNAL);
+        for(int frame = 0; frame < 5;){
+            gb->step();
+            frame += gb->signalRaised(FRAME_SIGNAL);
+        }
+    }
+    check(everyFrame.getFrameCount() == 5 && everyOther.getFrameCount() == 3 &&
+        everyFrame.getLastFrame() == everyOther.getLastFrame() &&
+        sameState(drawAll, drawNone) && sameState(drawAll, drawHalf));
+    remove(romSkip.c_str());
+
+    cout << "Unshown Input Latency Test" << endl;
+    //latency is only taken for frames that get shown, with no sink input still lands
+    const string romInput = "unshown_input.gb";
+    createPollRom(romInput);
+    MemoryFrameSink inputFrames;
+    Gameboy headless;
+    Gameboy shown;
+    headless.loadGame(romInput);
+    shown.loadGame(romInput);
+    shown.setFrameSink(&inputFrames);
+    for(Gameboy* gb : {&headless, &shown}){
+        gb->setFrameLimit(false);
+        gb->enableSignal(FRAME_SIGNAL);
+        for(int frame = 0; frame < 3;){
+            gb->postInput(frame % 2 ? JOYPAD_RELEASED : (Regval8)~A_BUTTON_MASK);
+            gb->step();
+            frame += gb->signalRaised(FRAME_SIGNAL);
+        }
+    }
+    check(headless.getInputStats().numInputs == 0 && shown.getInputStats().numInputs > 0 &&
+        headless.getJoypad() == shown.getJoypad());
+    remove(romInput.c_str());
+
+    cout << "Bus Lock Test" << endl;
+    Bus lockBus;
+    Memory<CPU_PERM> cpuMem(lockBus);
+    Memory<PPU_PERM> ppuMem(lockBus);
+    Memory<DMA_PERM> dmaMem(lockBus);
+    Memory<SYS_PERM> sysMem(lockBus);
+    cpuMem.write(VRAM_START, 0x12);
+    cpuMem.write(WRAM_START, 0x34);
+    //only the PPU locks VRAM, and only the CPU is kept out
+    bool vramLocked = ppuMem.lockVram() && !cpuMem.lockVram() &&
+        !cpuMem.write(VRAM_START, 0x56) && cpuMem.read(VRAM_START) == LOCKED_READ &&
+        sysMem.read(VRAM_START) == 0x12 && ppuMem.read(VRAM_START) == 0x12;
+    ppuMem.unlockVram();
+    //during DMA the CPU only gets HRAM and I/O
+    bool dmaLocked = dmaMem.lockMemoryDMA() && cpuMem.read(WRAM_START) == LOCKED_READ &&
+        !cpuMem.write(WRAM_START, 0x56) && cpuMem.write(HRAM_START, 0x78) &&
+        cpuMem.read(HRAM_START) == 0x78 && dmaMem.read(WRAM_START) == 0x34;
+    dmaMem.unlockMemoryDMA();
+    check(vramLocked && dmaLocked && cpuMem.read(WRAM_START) == 0x34 && cpuMem.read(VRAM_START) == 0x12);
+    return numFailures ? 1 : 0;
+}
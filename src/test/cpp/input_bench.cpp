@@ -0,0 +1,91 @@
+#include "gameboy.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <queue>
+
+using namespace std;
+
+constexpr double DEFAULT_BENCH_SECONDS = 3.0;
+//Several keys going down together, as when a player mashes a combination
+constexpr int BURST_SIZE = 4;
+constexpr chrono::milliseconds BURST_INTERVAL(97);
+
+typedef enum Delivery{
+    ONE_PER_FRAME,  //host events wait in a queue, one handed over per frame
+    POSTED          //host events are posted to the machine as they come
+}Delivery;
+
+typedef struct HostEvent{
+    Regval8 state;
+    chrono::high_resolution_clock::time_point happenedAt;
+}HostEvent;
+
+/*
+Runs the ROM in real time for a while, with a thread standing in for the host
+event source that sends bursts of button changes.
+*/
+InputStats measure(const string& rom, double seconds, Delivery delivery){
+    Gameboy gb;
+    gb.enableSignal(FRAME_SIGNAL);
+    gb.loadGame(rom);
+    mutex lock;
+    queue<HostEvent> hostQueue;
+    atomic<bool> done(false);
+    thread source([&](){
+        Regval8 state = JOYPAD_RELEASED;
+        while(!done){
+            for(int i = 0; i < BURST_SIZE; i++){
+                state ^= 1 << i;
+                HostEvent event = {state, chrono::high_resolution_clock::now()};
+                if(delivery == POSTED){
+                    gb.postInput(event.state, event.happenedAt);
+                }
+                else{
+                    lock_guard<mutex> guard(lock);
+                    hostQueue.push(event);
+                }
+            }
+            this_thread::sleep_for(BURST_INTERVAL);
+        }
+    });
+    chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now() +
+        chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double>(seconds));
+    while(chrono::high_resolution_clock::now() < end){
+        if(delivery == ONE_PER_FRAME && gb.signalRaised(FRAME_SIGNAL)){
+            lock_guard<mutex> guard(lock);
+            if(!hostQueue.empty()){
+                gb.postInput(hostQueue.front().state, hostQueue.front().happenedAt);
+                hostQueue.pop();
+            }
+        }
+        gb.step();
+    }
+    done = true;
+    source.join();
+    return gb.getInputStats();
+}
+
+/*
+Measures input-to-present latency, from a button change on the host to the
+first frame presented after the machine applied it.
+usage: inputbench <rom> [seconds]
+*/
+int main(int argc, char** argv){
+    if(argc < 2){
+        cout << "usage: " << argv[0] << " <rom> [seconds]" << endl;
+        return 1;
+    }
+    double seconds = argc > 2 ? stod(argv[2]) : DEFAULT_BENCH_SECONDS;
+    cout << "delivery         inputs   mean ms    max ms" << endl;
+    const pair<const char*, Delivery> deliveries[] = {{"one per frame", ONE_PER_FRAME}, {"posted", POSTED}};
+    for(const pair<const char*, Delivery>& delivery : deliveries){
+        InputStats stats = measure(string(argv[1]), seconds, delivery.second);
+        cout << delivery.first << string(17 - string(delivery.first).size(), ' ') << stats.numInputs << "\t"
+            << stats.meanLatencyMs << "\t" << stats.maxLatencyMs << endl;
+    }
+    return 0;
+}
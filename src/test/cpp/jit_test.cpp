@@ -0,0 +1,176 @@
+#include "gameboy.h"
+#include "instructions.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdio>
+
+using namespace std;
+
+constexpr char GREEN[] = "\033[32m";
+constexpr char RED[] = "\033[31m";
+constexpr char RESET[] = "\033[0m";
+
+constexpr int NUM_TEST_CYCLES = 2000000;
+constexpr int NUM_LOOP_OPS = 200;
+
+int numFailures = 0;
+
+void colorPrint(const char* color, const char* s){
+    cout << color << s << RESET << endl;
+}
+
+void check(bool passed){
+    if(passed){
+        colorPrint(GREEN, "SUCCESS");
+    }
+    else{
+        colorPrint(RED, "FAILURE");
+        numFailures++;
+    }
+}
+
+/*
+Builds a ROM that turns on the timer and vblank interrupts, then loops over
+random register-only instructions forever. Now and then an instruction the
+recompiler leaves alone splits the loop into several runs.
+*/
+void createRandomRom(string filename, unsigned seed){
+    mt19937 rng(seed);
+    string rom(2 * ROM_BANK_SIZE, 0x00);
+    const Regval8 entry[] = {
+        0x00,                   //NOP
+        0xC3, 0x50, 0x01        //JP $0150
+    };
+    vector<Regval8> program = {
+        0x31, 0x00, 0xD0,       //LD SP, $D000
+        0x3E, 0x05,             //LD A, 5
+        0xE0, 0x07,             //LDH (TAC), A
+        0xE0, 0xFF,             //LDH (IE), A
+        0xFB                    //EI
+    };
+    const Regval8 fallback[] = {DAA, LDH_IMM_A, SBC_A, DI, EI};
+    Regval16 loop = 0x150 + program.size();
+    const Regval8 misc[] = {
+        INC_BC, INC_DE, INC_HL, DEC_BC, DEC_DE, DEC_HL, ADD_HL_BC, ADD_HL_DE, ADD_HL_HL,
+        RLCA, RRCA, RLA, RRA, CPL, SCF, CCF, NOP
+    };
+    //register fields of B, C, D, E, H, L and A, leaving out (HL)
+    const Regval8 regs[] = {0, 1, 2, 3, 4, 5, 7};
+    for(int i = 0; i < NUM_LOOP_OPS; i++){
+        Regval8 r1 = regs[rng() % sizeof(regs)];
+        Regval8 r2 = regs[rng() % sizeof(regs)];
+        Regval8 field = rng() % 8;
+        Regval8 imm = rng() % 256;
+        switch(rng() % 10){
+            case 0:
+                program.insert(program.end(), {CB_OP, (Regval8)((rng() % 32) << 3 | r1)});
+                break;
+            case 1:
+                program.insert(program.end(), {(Regval8)(0x06 | r1 << 3), imm});        //LD r, imm
+                break;
+            case 2:
+                program.insert(program.end(), {(Regval8)(0xC6 | field << 3), imm});     //ALU A, imm
+                break;
+            case 3:
+                program.push_back(0x40 | r1 << 3 | r2);                                 //LD r, r'
+                break;
+            case 4:
+            case 5:
+                program.push_back(0x80 | field << 3 | r2);                              //ALU A, r
+                break;
+            case 6:
+                program.push_back((rng() % 2 ? 0x04 : 0x05) | r1 << 3);                 //INC r / DEC r
+                break;
+            case 7:
+            case 8:
+                program.push_back(misc[rng() % sizeof(misc)]);
+                break;
+            default:{
+                Regval8 other = fallback[rng() % sizeof(fallback)];
+                program.push_back(other);
+                if(other == LDH_IMM_A){
+                    program.push_back(0x80 + rng() % 0x7F);                             //somewhere in HRAM
+                }
+                break;
+            }
+        }
+    }
+    program.insert(program.end(), {0xC3, (Regval8)(loop & 0xFF), (Regval8)(loop >> 8)});    //JP loop
+    for(size_t i = 0; i < sizeof(entry); i++)
+        rom[0x100 + i] = entry[i];
+    for(size_t i = 0; i < program.size(); i++)
+        rom[0x150 + i] = program[i];
+    //every interrupt just returns
+    for(Regval16 isr = 0x40; isr <= 0x60; isr += 0x08)
+        rom[isr] = (char)RETI;
+    ofstream out(filename, ios_base::out | ios_base::binary);
+    out.write(rom.data(), rom.size());
+}
+
+bool sameState(Gameboy& gb1, Gameboy& gb2){
+    GbState s1 = gb1.getState();
+    GbState s2 = gb2.getState();
+    for(int i = 0; i < NUM_REGS_8; i++){
+        if(s1.regs_8[i] != s2.regs_8[i])
+            return false;
+    }
+    for(int i = 0; i < NUM_REGS_16; i++){
+        if(s1.regs_16[i] != s2.regs_16[i])
+            return false;
+    }
+    return true;
+}
+
+/*
+Runs the ROM on the recompiler and on the interpreter side by side, and
+compares the CPU state every time both have run the same number of cycles.
+*/
+bool runDifferential(string filename, long& jitSteps, long& interpSteps){
+    Gameboy jitGb;
+    Gameboy interpGb;
+    jitGb.loadGame(filename);
+    interpGb.loadGame(filename);
+    jitGb.setRunMode(INSTRUCTION_STEP);
+    interpGb.setRunMode(INSTRUCTION_STEP);
+    jitGb.setJitEnabled(true);
+    jitSteps = 0;
+    interpSteps = 0;
+    while(jitGb.getCycleCount() < NUM_TEST_CYCLES){
+        jitGb.step();
+        jitSteps++;
+        while(interpGb.getCycleCount() < jitGb.getCycleCount()){
+            interpGb.step();
+            interpSteps++;
+        }
+        if(interpGb.getCycleCount() != jitGb.getCycleCount() || !sameState(jitGb, interpGb) ||
+            jitGb.readMem(IF_REG_ADDR) != interpGb.readMem(IF_REG_ADDR)){
+            cout << "diverged at cycle " << jitGb.getCycleCount() << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+#ifndef USE_JIT
+    cout << "Built without JIT=1, nothing to test" << endl;
+    return 0;
+#else
+    const unsigned seeds[] = {1, 2, 3, 4};
+    for(unsigned seed : seeds){
+        const string rom = "jit_random.gb";
+        createRandomRom(rom, seed);
+        long jitSteps;
+        long interpSteps;
+        cout << "Recompiled Matches Interpreted Test (seed " << seed << ")" << endl;
+        bool same = runDifferential(rom, jitSteps, interpSteps);
+        //fewer steps means runs of several instructions went through compiled code
+        check(same && jitSteps < interpSteps);
+        remove(rom.c_str());
+    }
+    return numFailures ? 1 : 0;
+#endif
+}
@@ -0,0 +1,256 @@
+#include "memory.h"
+#include "mbc.h"
+#include "rom_image.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <iterator>
+#include <cstdio>
+
+using namespace std;
+
+constexpr char GREEN[] = "\033[32m";
+constexpr char RED[] = "\033[31m";
+constexpr char RESET[] = "\033[0m";
+
+int numFailures = 0;
+
+void colorPrint(const char* color, const char* s){
+    cout << color << s << RESET << endl;
+}
+
+void check(bool passed){
+    if(passed){
+        colorPrint(GREEN, "SUCCESS");
+    }
+    else{
+        colorPrint(RED, "FAILURE");
+        numFailures++;
+    }
+}
+
+/*
+Builds a ROM whose banks start with their own number, low byte first, so the
+bank switched into either half of the map can be read back directly.
+*/
+void createRom(string filename, Regval8 cartType, Regval8 sizeCode, Regval8 ramCode, int numBanks){
+    string rom((size_t)numBanks * ROM_BANK_SIZE, 0x00);
+    for(int bank = 0; bank < numBanks; bank++){
+        rom[(size_t)bank * ROM_BANK_SIZE] = (char)(bank & 0xFF);
+        rom[(size_t)bank * ROM_BANK_SIZE + 1] = (char)(bank >> 8);
+    }
+    rom[0x147] = cartType;
+    rom[ROM_SIZE_BYTE_ADDR] = sizeCode;
+    rom[RAM_SIZE_BYTE_ADDR] = ramCode;
+    ofstream out(filename, ios_base::out | ios_base::binary);
+    out.write(rom.data(), rom.size());
+}
+
+void loadRom(Memory<SYS_PERM>& mem, string filename){
+    mem.mapRom(RomImage::open(filename));
+    mem.resolveCartridgeType();
+}
+
+int bankAt(Memory<SYS_PERM>& mem, Regval16 addr){
+    return mem.read(addr) | mem.read(addr + 1) << 8;
+}
+
+void latchRtc(Memory<SYS_PERM>& mem){
+    mem.write(BANKING_MODE_SELECT_START, 0x00);
+    mem.write(BANKING_MODE_SELECT_START, 0x01);
+}
+
+Regval8 readRtc(Memory<SYS_PERM>& mem, Regval8 reg){
+    mem.write(RAM_BANK_SELECT_START, reg);
+    return mem.read(RAM_BANK_START);
+}
+
+void writeRtc(Memory<SYS_PERM>& mem, Regval8 reg, Regval8 byte){
+    mem.write(RAM_BANK_SELECT_START, reg);
+    mem.write(RAM_BANK_START, byte);
+}
+
+int main(int argc, char** argv){
+    const string rom = "mbc_test.gb";
+    {
+        cout << "MBC1 Bank Select Test" << endl;
+        Bus bus;
+        Memory<SYS_PERM> mem(bus);
+        createRom(rom, MBC1, 0x02, 0x00, 8);
+        loadRom(mem, rom);
+        int first = bankAt(mem, ROM_BANK_N_START);
+        //only five bits are wired up, so 0x21 is bank 1 rather than 0x21 or 0
+        mem.write(ROM_BANK_SELECT_START, 0x21);
+        int masked = bankAt(mem, ROM_BANK_N_START);
+        mem.write(ROM_BANK_SELECT_START, 0x05);
+        int fifth = bankAt(mem, ROM_BANK_N_START);
+        //past the end of the ROM wraps around
+        mem.write(ROM_BANK_SELECT_START, 0x0B);
+        int wrapped = bankAt(mem, ROM_BANK_N_START);
+        check(first == 1 && masked == 1 && fifth == 5 && wrapped == 3);
+    }
+    {
+        cout << "MBC1 Advanced Mode Test" << endl;
+        Bus bus;
+        Memory<SYS_PERM> mem(bus);
+        createRom(rom, MBC1_RAM_BATTERY, 0x06, 0x03, 128);
+        loadRom(mem, rom);
+        mem.write(ROM_BANK_SELECT_START, 0x02);
+        mem.write(RAM_BANK_SELECT_START, 0x01);
+        int simpleLow = bankAt(mem, ROM_BANK_0_START);
+        int simpleHigh = bankAt(mem, ROM_BANK_N_START);
+        mem.write(BANKING_MODE_SELECT_START, 0x01);
+        int advancedLow = bankAt(mem, ROM_BANK_0_START);
+        int advancedHigh = bankAt(mem, ROM_BANK_N_START);
+        //the upper bits switch the RAM bank only in advanced mode
+        mem.write(RAM_BANK_ENABLE_START, 0x0A);
+        mem.write(RAM_BANK_START, 0x11);
+        mem.write(BANKING_MODE_SELECT_START, 0x00);
+        Regval8 bank0 = mem.read(RAM_BANK_START);
+        mem.write(RAM_BANK_ENABLE_START, 0x00);
+        Regval8 disabled = mem.read(RAM_BANK_START);
+        check(simpleLow == 0 && simpleHigh == 0x22 && advancedLow == 0x20 && advancedHigh == 0x22 &&
+            bank0 == 0x00 && (*bus.cartRam)[RAM_BANK_BANK_SIZE] == 0x11 && disabled == 0xFF);
+    }
+    {
+        cout << "MBC2 Nibble RAM Test" << endl;
+        Bus bus;
+        Memory<SYS_PERM> mem(bus);
+        createRom(rom, MBC2_BATTERY, 0x03, 0x00, 16);
+        loadRom(mem, rom);
+        //bit 8 of the address picks the register
+        mem.write(0x0100, 0x03);
+        mem.write(0x0000, 0x0A);
+        int bank = bankAt(mem, ROM_BANK_N_START);
+        mem.write(RAM_BANK_START + 0x10, 0xAB);
+        Regval8 stored = mem.read(RAM_BANK_START + 0x10);
+        Regval8 mirrored = mem.read(RAM_BANK_START + MBC2_RAM_SIZE + 0x10);
+        check(bank == 3 && stored == 0xFB && mirrored == 0xFB && bus.cartRam->getSize() == MBC2_RAM_SIZE);
+    }
+    {
+        cout << "MBC3 RTC Register Test" << endl;
+        Bus bus;
+        Memory<SYS_PERM> mem(bus);
+        createRom(rom, MBC3_TIMER_RAM_BATTERY, 0x06, 0x03, 128);
+        loadRom(mem, rom);
+        mem.write(ROM_BANK_SELECT_START, 0x45);
+        int bank = bankAt(mem, ROM_BANK_N_START);
+        mem.write(RAM_BANK_ENABLE_START, 0x0A);
+        mem.write(RAM_BANK_SELECT_START, 0x02);
+        mem.write(RAM_BANK_START, 0x77);
+        //seconds register, reads only see it after a latch
+        mem.write(RAM_BANK_SELECT_START, 0x08);
+        mem.write(RAM_BANK_START, 0x2A);
+        Regval8 beforeLatch = mem.read(RAM_BANK_START);
+        mem.write(BANKING_MODE_SELECT_START, 0x00);
+        mem.write(BANKING_MODE_SELECT_START, 0x01);
+        Regval8 afterLatch = mem.read(RAM_BANK_START);
+        mem.write(RAM_BANK_SELECT_START, 0x02);
+        Regval8 ram = mem.read(RAM_BANK_START);
+        check(bank == 0x45 && beforeLatch == 0x00 && afterLatch == 0x2A && ram == 0x77);
+    }
+    {
+        cout << "MBC3 RTC Timekeeping Test" << endl;
+        Bus bus;
+        uint64_t cycles = 0;
+        bus.cycleCount = [&cycles](){
+            return cycles;
+        };
+        Memory<SYS_PERM> mem(bus);
+        createRom(rom, MBC3_TIMER_RAM_BATTERY, 0x01, 0x03, 4);
+        loadRom(mem, rom);
+        mem.write(RAM_BANK_ENABLE_START, 0x0A);
+        //one second before day 512, which rolls over to day 0 with the carry set
+        writeRtc(mem, 0x08, 59);
+        writeRtc(mem, 0x09, 59);
+        writeRtc(mem, 0x0A, 23);
+        writeRtc(mem, 0x0B, 0xFF);
+        writeRtc(mem, 0x0C, 0x01);
+        //emulated time is all that counts, however fast it went by
+        cycles += RTC_CYCLES_PER_SECOND;
+        //reads only see the clock as of the last latch
+        Regval8 beforeLatch = readRtc(mem, 0x08);
+        latchRtc(mem);
+        bool rolledOver = readRtc(mem, 0x08) == 0 && readRtc(mem, 0x09) == 0 && readRtc(mem, 0x0A) == 0 &&
+            readRtc(mem, 0x0B) == 0 && readRtc(mem, 0x0C) == 0x80;
+        cycles += 90 * RTC_CYCLES_PER_SECOND + RTC_CYCLES_PER_SECOND / 2;
+        latchRtc(mem);
+        bool counted = readRtc(mem, 0x08) == 30 && readRtc(mem, 0x09) == 1;
+        //halted, the clock stands still. Writing the halt bit alone clears the carry.
+        writeRtc(mem, 0x0C, 0x40);
+        cycles += 3600 * RTC_CYCLES_PER_SECOND;
+        latchRtc(mem);
+        bool halted = readRtc(mem, 0x09) == 1 && readRtc(mem, 0x0A) == 0;
+        //the save holds the time it was made, a day later the clock has moved on by a day
+        writeRtc(mem, 0x0C, 0x00);
+        Regval8 trailer[RTC_TRAILER_SIZE];
+        bus.mbc->saveTrailer(trailer);
+        uint64_t savedAt = 0;
+        for(int i = 0; i < 8; i++)
+            savedAt |= (uint64_t)trailer[40 + i] << (8 * i);
+        savedAt -= 24 * 3600;
+        for(int i = 0; i < 8; i++)
+            trailer[40 + i] = (savedAt >> (8 * i)) & 0xFF;
+        bus.mbc->loadTrailer(trailer, RTC_TRAILER_SIZE);
+        latchRtc(mem);
+        bool restored = readRtc(mem, 0x09) == 1 && readRtc(mem, 0x0B) == 1 && readRtc(mem, 0x0C) == 0x00;
+        check(beforeLatch == 0 && rolledOver && counted && halted && restored &&
+            bus.mbc->getTrailerSize() == RTC_TRAILER_SIZE);
+    }
+    {
+        cout << "MBC5 Large ROM Test" << endl;
+        Bus bus;
+        Memory<SYS_PERM> mem(bus);
+        //an 8 MiB header over a file just past 4 MiB is enough to reach bank 0x100
+        createRom(rom, MBC5_RAM_BATTERY, 0x08, 0x04, 0x101);
+        loadRom(mem, rom);
+        mem.write(ROM_BANK_SELECT_START, 0x00);
+        int zero = bankAt(mem, ROM_BANK_N_START);
+        mem.write(0x3000, 0x01);
+        int high = bankAt(mem, ROM_BANK_N_START);
+        mem.write(RAM_BANK_ENABLE_START, 0x0A);
+        mem.write(RAM_BANK_SELECT_START, 0x0F);
+        mem.write(RAM_BANK_START, 0x5A);
+        check(zero == 0 && high == 0x100 && bus.cartRam->getSize() == 16 * RAM_BANK_BANK_SIZE &&
+            (*bus.cartRam)[15 * RAM_BANK_BANK_SIZE] == 0x5A);
+    }
+    {
+        cout << "Save File Mapping Test" << endl;
+        const string save = "mbc_test.sav";
+        //a save shorter than the RAM is padded out
+        string oldSave(0x100, 0x00);
+        oldSave[0] = 0x42;
+        {
+            ofstream out(save, ios_base::out | ios_base::binary);
+            out.write(oldSave.data(), oldSave.size());
+        }
+        bool mapped;
+        bool cleanProtected;
+        bool dirtyMapped;
+        bool flushedProtected;
+        Regval8 loaded;
+        {
+            Bus bus;
+            Memory<SYS_PERM> mem(bus);
+            createRom(rom, MBC1_RAM_BATTERY, 0x01, 0x03, 4);
+            loadRom(mem, rom);
+            mapped = mem.mapRamState(save);
+            mem.write(RAM_BANK_ENABLE_START, 0x0A);
+            loaded = mem.read(RAM_BANK_START);
+            //the first store to a page goes through the MBC to mark it dirty
+            cleanProtected = bus.writePages[RAM_BANK_START / MEM_PAGE_SIZE] == nullptr;
+            mem.write(RAM_BANK_START + 1, 0x99);
+            dirtyMapped = bus.writePages[RAM_BANK_START / MEM_PAGE_SIZE] != nullptr;
+            mem.flushRamState();
+            flushedProtected = bus.writePages[RAM_BANK_START / MEM_PAGE_SIZE] == nullptr;
+            mem.write(RAM_BANK_START + 2, 0x77);
+        }
+        ifstream in(save, ios_base::in | ios_base::binary);
+        string contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        check(mapped && loaded == 0x42 && cleanProtected && dirtyMapped && flushedProtected &&
+            contents.size() == 4 * RAM_BANK_BANK_SIZE && contents[1] == (char)0x99 && contents[2] == 0x77);
+        remove(save.c_str());
+    }
+    remove(rom.c_str());
+    return numFailures ? 1 : 0;
+}
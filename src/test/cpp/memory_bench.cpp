@@ -0,0 +1,84 @@
+#include "memory.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <memory>
+
+using namespace std;
+
+constexpr long DEFAULT_BENCH_ACCESSES = 200000000;
+
+typedef struct Region{
+    const char* name;
+    Regval16 start;
+    Regval16 end;
+}Region;
+
+const Region REGIONS[] = {
+    {"rom bank 0", ROM_BANK_0_START, ROM_BANK_0_END},
+    {"rom bank n", ROM_BANK_N_START, ROM_BANK_N_END},
+    {"cart ram", RAM_BANK_START, RAM_BANK_END},
+    {"wram", WRAM_START, WRAM_END},
+    {"hram", HRAM_START, HRAM_END}
+};
+
+/*
+Walks a region with a stride that isn't a power of two, so that accesses
+don't stay on one page.
+*/
+int nextOffset(int offset, const Region& region){
+    offset += 97;
+    if(offset > region.end - region.start)
+        offset -= region.end - region.start + 1;
+    return offset;
+}
+
+double timeReads(const Memory<CPU_PERM>& mem, const Region& region, long n, Regval8& sink){
+    int offset = 0;
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    for(long i = 0; i < n; i++){
+        sink += mem.read(region.start + offset);
+        offset = nextOffset(offset, region);
+    }
+    chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+    return n / elapsed.count();
+}
+
+double timeWrites(const Memory<CPU_PERM>& mem, const Region& region, long n){
+    int offset = 0;
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    for(long i = 0; i < n; i++){
+        mem.write(region.start + offset, (Regval8)i);
+        offset = nextOffset(offset, region);
+    }
+    chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+    return n / elapsed.count();
+}
+
+/*
+Measures raw Memory::read/write throughput per region of the memory map, with
+the cartridge RAM enabled. Writes to ROM only go to the MBC registers, so
+only reads are timed there.
+usage: memorybench [accesses]
+*/
+int main(int argc, char** argv){
+    long numAccesses = argc > 1 ? stol(argv[1]) : DEFAULT_BENCH_ACCESSES;
+    long perRegion = numAccesses / (sizeof(REGIONS) / sizeof(REGIONS[0]));
+    unique_ptr<Bus> bus(new Bus());
+    Memory<CPU_PERM> mem(*bus);
+    mem.write(RAM_BANK_ENABLE_START, 0x0A);
+    Regval8 sink = 0;
+    cout << "region        reads/sec      writes/sec" << endl;
+    for(const Region& region : REGIONS){
+        double reads = timeReads(mem, region, perRegion, sink);
+        cout << region.name << string(14 - string(region.name).size(), ' ') << (long)reads;
+        if(region.start > ROM_BANK_N_END){
+            double writes = timeWrites(mem, region, perRegion);
+            cout << string(15 - to_string((long)reads).size(), ' ') << (long)writes;
+        }
+        cout << endl;
+    }
+    //keeps the reads from being optimised away
+    cout << "checksum: " << (int)sink << endl;
+    return 0;
+}
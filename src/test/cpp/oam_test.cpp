@@ -6,11 +6,12 @@
 
 using namespace std;
 
-void createObject(Regval8 entryNum, Regval8 yPos, Regval8 xPos, Memory& mem);
+void createObject(Regval8 entryNum, Regval8 yPos, Regval8 xPos, Memory<SYS_PERM>& mem);
 
 int main(int argc, char** argv){
-    Memory mem(SYS_PERM);
-    OAM oam;
+    Bus bus;
+    Memory<SYS_PERM> mem(bus);
+    OAM oam(bus);
     //test 1
     int xPos;
     int yPos;
@@ -37,7 +38,7 @@ int main(int argc, char** argv){
     return 0;
 }
 
-void createObject(Regval8 entryNum, Regval8 yPos, Regval8 xPos, Memory& mem){
+void createObject(Regval8 entryNum, Regval8 yPos, Regval8 xPos, Memory<SYS_PERM>& mem){
     Regval16 addr = OAM_START + (entryNum * OBJECT_SIZE);
     mem.write(addr, yPos);
     mem.write(addr+1, xPos);
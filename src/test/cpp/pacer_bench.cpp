@@ -0,0 +1,108 @@
+#include "gameboy.h"
+#include "frame_pacer.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+constexpr double DEFAULT_BENCH_SECONDS = 5.0;
+constexpr double BENCH_FRAME_RATE = 59.7;
+
+typedef enum Pacing{
+    SPIN,   //busy-wait until a frame time has passed since the last frame
+    HYBRID  //FramePacer, sleep then spin for the last stretch
+}Pacing;
+
+typedef struct PacingResult{
+    double cpuPercent;
+    double meanFrameMs;
+    double jitterMs;
+    double maxDeviationMs;
+}PacingResult;
+
+/*
+The pacer the PPU used to have, kept here to compare against.
+*/
+void spinWait(chrono::high_resolution_clock::time_point& lastFrameTime){
+    const chrono::duration<double> targetFrameDuration(1.0 / BENCH_FRAME_RATE);
+    while(true){
+        chrono::high_resolution_clock::time_point currentTime = chrono::high_resolution_clock::now();
+        if((currentTime - lastFrameTime) > targetFrameDuration){
+            lastFrameTime = currentTime;
+            break;
+        }
+    }
+}
+
+/*
+Runs the ROM in real time for a while, paced at every frame by the method given,
+and times the frames as they are released.
+*/
+PacingResult measure(const string& rom, double seconds, Pacing pacing){
+    Gameboy gb;
+    gb.setFrameLimit(false);
+    gb.enableSignal(FRAME_SIGNAL);
+    gb.loadGame(rom);
+    FramePacer pacer(BENCH_FRAME_RATE);
+    chrono::high_resolution_clock::time_point lastFrameTime = chrono::high_resolution_clock::now();
+    const double periodMs = 1000.0 / BENCH_FRAME_RATE;
+    double sumMs = 0;
+    double sumSqMs = 0;
+    double maxDeviationMs = 0;
+    int numFrames = 0;
+    chrono::steady_clock::time_point lastRelease;
+    clock_t cpuStart = clock();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    chrono::steady_clock::time_point end = start +
+        chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+    while(chrono::steady_clock::now() < end){
+        gb.step();
+        if(!gb.signalRaised(FRAME_SIGNAL)){
+            continue;
+        }
+        if(pacing == SPIN){
+            spinWait(lastFrameTime);
+        }
+        else{
+            pacer.wait();
+        }
+        chrono::steady_clock::time_point release = chrono::steady_clock::now();
+        //the first frame only sets the schedule up
+        if(numFrames++ > 0){
+            double frameMs = chrono::duration<double, milli>(release - lastRelease).count();
+            sumMs += frameMs;
+            sumSqMs += frameMs * frameMs;
+            maxDeviationMs = max(maxDeviationMs, abs(frameMs - periodMs));
+        }
+        lastRelease = release;
+    }
+    double cpuSeconds = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+    double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    int timed = max(numFrames - 1, 1);
+    double meanMs = sumMs / timed;
+    return {100 * cpuSeconds / wallSeconds, meanMs, sqrt(max(sumSqMs / timed - meanMs * meanMs, 0.0)), maxDeviationMs};
+}
+
+/*
+Compares host CPU use and frame time jitter of the old busy-wait pacer and FramePacer.
+usage: pacerbench <rom> [seconds]
+*/
+int main(int argc, char** argv){
+    if(argc < 2){
+        cout << "usage: " << argv[0] << " <rom> [seconds]" << endl;
+        return 1;
+    }
+    double seconds = argc > 2 ? stod(argv[2]) : DEFAULT_BENCH_SECONDS;
+    cout << "pacing   cpu %   mean ms   jitter ms   max dev ms" << endl;
+    const pair<const char*, Pacing> pacings[] = {{"spin", SPIN}, {"hybrid", HYBRID}};
+    for(const pair<const char*, Pacing>& pacing : pacings){
+        PacingResult result = measure(string(argv[1]), seconds, pacing.second);
+        cout << pacing.first << string(9 - string(pacing.first).size(), ' ') << result.cpuPercent << "\t"
+            << result.meanFrameMs << "\t" << result.jitterMs << "\t" << result.maxDeviationMs << endl;
+    }
+    return 0;
+}